@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include "glextloader.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Times every stage of the loader generator on the real headers and on bigger synthetic
+/// ones. Nothing here needs a GL context.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+class Stage
+{
+public:
+    std::string name;
+    double seconds;
+};
+
+template <class Function>
+double Time(int repeat, Function function)
+{
+    double best = 0.0;
+    for (int i = 0; i < repeat; i++)
+    {
+        auto start = Clock::now();
+        function();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+// Glues the header together count times, so it has count times as many features
+std::string MakeSynthetic(std::string_view header, int count)
+{
+    std::string result;
+    result.reserve(header.size() * size_t(count));
+    for (int i = 0; i < count; i++) result.append(header);
+    return result;
+}
+
+void Report(const std::string& name, std::string_view header, size_t featureCount, const std::vector<Stage>& stages)
+{
+    double megabytes = double(header.size()) / (1024.0 * 1024.0);
+
+    std::cout << name << ": " << std::fixed << std::setprecision(2) << megabytes << " MB, " << featureCount << " features" << std::endl;
+    for (auto& stage : stages)
+    {
+        std::cout << "    " << std::left << std::setw(32) << stage.name << std::right
+                  << std::setw(10) << std::setprecision(3) << stage.seconds * 1000.0 << " ms"
+                  << std::setw(12) << std::setprecision(1) << megabytes / stage.seconds << " MB/s"
+                  << std::setw(14) << std::setprecision(0) << double(featureCount) / stage.seconds << " features/s"
+                  << std::endl;
+    }
+}
+
+void Bench(const std::string& name, std::string_view header, const GeneratorOptions& options, int repeat, int jobs)
+{
+    std::vector<Stage> stages;
+    std::vector<Feature> features;
+
+    stages.push_back({ "LoadFeatures", Time(repeat, [&]() { features = LoadFeatures(header, jobs); }) });
+
+    // Collect the prototypes and type definitions up front so only the mapping itself is timed
+    std::vector<std::vector<Prototype>> prototypes;
+    std::vector<std::vector<TypeDefinition>> typeDefinitions;
+    for (auto chunk : SplitFeatures(header))
+    {
+        prototypes.push_back(std::vector<Prototype>());
+        typeDefinitions.push_back(std::vector<TypeDefinition>());
+
+        std::string_view line;
+        while (NextLine(chunk, line))
+        {
+            if (IsTypeDefinition(line)) typeDefinitions.back().push_back(ReadTypeDefinition(line));
+            else if (IsPrototype(line)) prototypes.back().push_back(ReadPrototype(line));
+        }
+    }
+
+    stages.push_back({ "MapPrototypeToTypeDefinitions", Time(repeat, [&]()
+    {
+        for (size_t i = 0; i < prototypes.size(); i++)
+            MapPrototypeToTypeDefinitions(prototypes[i], typeDefinitions[i]);
+    }) });
+
+    Aliases aliases;
+    stages.push_back({ "FindAliases", Time(repeat, [&]() { aliases = FindAliases(features); }) });
+
+    std::string implementation;
+    stages.push_back({ "WriteFeatures", Time(repeat, [&]() { implementation = WriteFeatures(features, aliases, jobs); }) });
+
+    // The same tree gl-utilities-extensions writes glextl.h from, built up front so only writing it out is timed
+    Writer declarations = WriteDeclarations(features, options);
+    Writer tree = WriteImplementation(implementation);
+    std::string written;
+    stages.push_back({ "Writer::Write", Time(repeat, [&]()
+    {
+        written.clear();
+        WriteHeader(written, declarations, &tree);
+    }) });
+
+    Report(name, header, features.size(), stages);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc == 1)
+    {
+        std::cout << "Usage: gl-utilities-generator-bench <source folder> [--jobs N] [--repeat N]" << std::endl;
+        return 1;
+    }
+
+    std::string sourcefolder = argv[1];
+    int jobs = 1;
+    int repeat = 5;
+    for (int i = 2; i < argc; i++)
+    {
+        if ((std::string(argv[i]) == "--jobs" || std::string(argv[i]) == "-j") && i + 1 < argc)
+            jobs = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+    }
+
+    std::cout << "Best of " << repeat << " runs, " << jobs << " job(s)" << std::endl;
+
+    for (auto filename : { "glext.h", "glcorearb.h" })
+    {
+        std::string path = sourcefolder + "/include/GL/" + filename;
+        MappedFile header(path);
+        if (!header.IsOpen())
+        {
+            std::cout << "Unable to open " << path << std::endl;
+            return 1;
+        }
+
+        // glcorearb.h is what the core profile is generated from
+        GeneratorOptions options;
+        if (std::string(filename) == "glcorearb.h") options.profile = "core";
+
+        Bench(filename, header.View(), options, repeat, jobs);
+
+        std::string synthetic = MakeSynthetic(header.View(), 10);
+        Bench(std::string(filename) + " x10", synthetic, options, repeat, jobs);
+
+        synthetic = MakeSynthetic(header.View(), 100);
+        Bench(std::string(filename) + " x100", synthetic, options, std::max(1, repeat / 5), jobs);
+    }
+
+    return 0;
+}
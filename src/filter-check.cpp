@@ -0,0 +1,138 @@
+#include <iostream>
+#include <string>
+
+#define GLEXTL_NULL
+#define GLEXTL_FILTER
+#define GLEXTL_IMPLEMENTATION
+#include <GL/glextl.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Checks the state filter of the loader on the null backend: which calls GLEXTL_FILTER
+/// drops and which it makes, counted by the filter and by the null backend behind it.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+static int failures = 0;
+static unsigned long long made = 0;
+
+// Starts counting on the current context
+void Start()
+{
+    glExtFilterFrame();
+    made = glExtNullCalls(nullptr);
+}
+
+// Compares the calls the filter dropped and forwarded since the last check, and the calls that reached the null
+// backend, with what was expected. Delete and indexed calls are always made without being counted by the filter.
+void Expect(const std::string& what, unsigned long long filtered, unsigned long long forwarded, unsigned long long calls)
+{
+    GLExtFilterCounts counts = glExtFilterFrame();
+    unsigned long long now = glExtNullCalls(nullptr);
+    if (counts.filtered != filtered || counts.forwarded != forwarded || now - made != calls)
+    {
+        std::cout << "FAILED " << what << ": " << counts.filtered << " filtered, " << counts.forwarded << " forwarded and "
+                  << now - made << " made, expected " << filtered << ", " << forwarded << " and " << calls << std::endl;
+        failures++;
+    }
+    made = now;
+}
+
+int main()
+{
+    if (!glExtLoadAll(glExtNullGetProc))
+    {
+        std::cout << "Unable to load the null backend" << std::endl;
+        return 1;
+    }
+
+    // The null backend starts at texture unit 0, which the reset reads
+    glExtFilterReset();
+    Start();
+
+    glUseProgram(1);
+    glUseProgram(1);
+    glUseProgram(2);
+    Expect("glUseProgram", 1, 2, 2);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 5);
+    glBindBuffer(GL_ARRAY_BUFFER, 5);
+    glBindBuffer(GL_UNIFORM_BUFFER, 5);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 5);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 5);
+    Expect("glBindBuffer per target, untracked targets always made", 1, 4, 4);
+
+    // Deleting the bound buffer binds zero, so binding zero again changes nothing
+    GLuint buffer = 5;
+    glDeleteBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 5);
+    Expect("glBindBuffer after glDeleteBuffers", 1, 1, 2);
+
+    // The element array buffer belongs to the vertex array
+    glBindVertexArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 3);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 3);
+    glBindVertexArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 3);
+    glBindVertexArray(2);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 3);
+    Expect("element array buffer per vertex array", 3, 4, 4);
+
+    // Texture bindings are kept per unit, and the reset found unit 0 active
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 7);
+    glBindTexture(GL_TEXTURE_2D, 7);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 7);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 7);
+    glActiveTexture(GL_TEXTURE1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 7);
+    Expect("glBindTexture per unit and target", 4, 5, 5);
+
+    glBindTextureUnit(0, 8);
+    glBindTexture(GL_TEXTURE_2D, 7);
+    Expect("glBindTexture after glBindTextureUnit", 0, 1, 2);
+
+    glEnable(GL_BLEND);
+    glEnable(GL_BLEND);
+    glDisable(GL_BLEND);
+    glEnablei(GL_BLEND, 1);
+    glDisable(GL_BLEND);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_TEXTURE_2D);
+    Expect("glEnable and glDisable, glEnablei forgets the cap", 1, 5, 6);
+
+    // A change the wrappers do not see leaves the shadow state behind until glExtFilterReset
+    GLEXTL_DISPATCH.UseProgram(1);
+    glUseProgram(2);
+    Expect("glUseProgram after a change without the wrappers", 1, 0, 1);
+    glExtFilterReset();
+    glUseProgram(2);
+    glUseProgram(2);
+    Expect("glUseProgram after glExtFilterReset, which reads the active unit", 1, 1, 2);
+
+    // Without the filter every call is made, and the state is still tracked
+    glExtFilterEnable(GL_FALSE);
+    glUseProgram(3);
+    glUseProgram(3);
+    Expect("glUseProgram with the filter off", 0, 2, 2);
+    glExtFilterEnable(GL_TRUE);
+    glUseProgram(3);
+    Expect("glUseProgram with the filter on again", 1, 0, 0);
+
+    // Every context has a shadow state of its own
+    GLExtContext* other = glExtCreateContext();
+    glExtMakeCurrent(other);
+    glExtLoadAll(glExtNullGetProc);
+    Start();
+    glUseProgram(3);
+    glUseProgram(3);
+    Expect("glUseProgram on another context, which resets on its first call", 1, 1, 2);
+    glExtMakeCurrent(nullptr);
+    glUseProgram(3);
+    Expect("glUseProgram back on the default context", 1, 0, 0);
+    glExtDestroyContext(other);
+
+    if (failures == 0) std::cout << "All state filter checks passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#include "glextloader.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Feature filtering
+////////////////////////////////////////////////////////////////////////////////////////////
+// Reads the version out of a feature name like "GL_VERSION_4_5"
+bool ParseVersionFeature(std::string_view name, int& major, int& minor)
+{
+    static const std::string_view prefix("GL_VERSION_");
+
+    if (name.compare(0, prefix.size(), prefix) != 0) return false;
+    name.remove_prefix(prefix.size());
+
+    std::string_view::size_type separator = name.find('_');
+    if (separator == 0 || separator == std::string_view::npos || separator + 1 == name.size()) return false;
+
+    major = 0;
+    minor = 0;
+    for (auto c : name.substr(0, separator))
+    {
+        if (c < '0' || c > '9') return false;
+        major = major * 10 + (c - '0');
+    }
+    for (auto c : name.substr(separator + 1))
+    {
+        if (c < '0' || c > '9') return false;
+        minor = minor * 10 + (c - '0');
+    }
+
+    return true;
+}
+
+std::vector<Feature> FilterFeatures(std::vector<Feature> features, const GeneratorOptions& options)
+{
+    std::vector<Feature> result;
+    result.reserve(features.size());
+
+    for (auto& feature : features)
+    {
+        int major = 0, minor = 0;
+        if (ParseVersionFeature(feature.name, major, minor))
+        {
+            if (options.majorVersion >= 0 && (major > options.majorVersion || (major == options.majorVersion && minor > options.minorVersion)))
+                continue;
+        }
+        else if (!options.allExtensions && options.extensions.find(feature.name) == options.extensions.end())
+            continue;
+
+        // Only keep the entry points the application uses, and the features it uses them or names them from
+        if (options.usedOnly)
+        {
+            for (auto mapped = feature.mapped.begin(); mapped != feature.mapped.end(); )
+            {
+                if (options.usedNames.find(mapped->first.name) == options.usedNames.end())
+                    mapped = feature.mapped.erase(mapped);
+                else
+                    ++mapped;
+            }
+
+            if (feature.mapped.empty() && options.usedNames.find(feature.name) == options.usedNames.end())
+                continue;
+        }
+
+        result.push_back(std::move(feature));
+    }
+
+    // Point out typos in the requested extensions
+    if (!options.allExtensions)
+    {
+        for (auto& extension : options.extensions)
+        {
+            bool found = false;
+            for (auto& feature : result) found = found || feature.name == extension;
+            if (!found) std::cout << "Extension " << extension << " not found" << std::endl;
+        }
+    }
+
+    return result;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Alias detection
+////////////////////////////////////////////////////////////////////////////////////////////
+// The return and parameter types of a prototype without the names, "void APIENTRY glFoo (GLenum mode, const void *p)"
+// becomes "void(GLenum,constvoid*)"
+std::string SignatureOf(std::string_view decl)
+{
+    std::string result;
+    auto add = [&](std::string_view part)
+    {
+        for (auto c : part) if (c != ' ') result.push_back(c);
+    };
+
+    std::string_view::size_type entry = decl.find("APIENTRY ");
+    std::string_view::size_type open = decl.find('(', entry);
+    std::string_view::size_type close = decl.find_last_of(')');
+    if (entry == std::string_view::npos || open == std::string_view::npos || close == std::string_view::npos || close < open) return result;
+
+    add(decl.substr(0, entry));
+    result.push_back('(');
+
+    std::string_view params = decl.substr(open + 1, close - open - 1);
+    while (!params.empty())
+    {
+        std::string_view::size_type comma = params.find(',');
+        std::string_view param = params.substr(0, comma);
+        params.remove_prefix(comma == std::string_view::npos ? params.size() : comma + 1);
+
+        // Drop the parameter name, but keep an array size behind it
+        std::string_view::size_type array = param.find('[');
+        std::string_view suffix = array == std::string_view::npos ? std::string_view() : param.substr(array);
+        param = param.substr(0, array);
+        while (!param.empty() && param.back() == ' ') param.remove_suffix(1);
+        std::string_view::size_type name = param.find_last_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+        if (name != std::string_view::npos && param != "void") param = param.substr(0, name + 1);
+
+        add(param);
+        add(suffix);
+        if (!params.empty()) result.push_back(',');
+    }
+
+    result.push_back(')');
+    return result;
+}
+
+// Finds the extension entry points that are a core entry point with an ARB, KHR or EXT suffix and the same signature,
+// like glDrawArraysInstancedARB for glDrawArraysInstanced. Vendor extensions are left out, most of their look alikes
+// work differently, and so do these two with a matching signature.
+Aliases FindAliases(const std::vector<Feature>& features)
+{
+    static const std::set<std::string_view> different = { "glIsProgramARB", "glGetObjectLabelEXT" };
+
+    std::map<std::string_view, std::string> core;
+    int major, minor;
+    for (auto& feature : features)
+        if (ParseVersionFeature(feature.name, major, minor))
+            for (auto& mappedPrototype : feature.mapped)
+                core.insert(std::make_pair(mappedPrototype.first.name, SignatureOf(mappedPrototype.first.decl)));
+
+    auto rank = [](std::string_view suffix)
+    {
+        if (suffix == "ARB") return 0;
+        if (suffix == "KHR") return 1;
+        if (suffix == "EXT") return 2;
+        return -1;
+    };
+
+    std::map<std::string_view, std::vector<std::pair<int, std::string_view>>> found;
+    for (auto& feature : features)
+    {
+        if (ParseVersionFeature(feature.name, major, minor)) continue;
+
+        for (auto& mappedPrototype : feature.mapped)
+        {
+            std::string_view name = mappedPrototype.first.name;
+            if (name.size() <= 3 || different.count(name) != 0) continue;
+
+            int r = rank(name.substr(name.size() - 3));
+            auto c = core.find(name.substr(0, name.size() - 3));
+            if (r >= 0 && c != core.end() && c->second == SignatureOf(mappedPrototype.first.decl))
+                found[c->first].push_back(std::make_pair(r, name));
+        }
+    }
+
+    Aliases result;
+    for (auto& f : found)
+    {
+        std::stable_sort(f.second.begin(), f.second.end(), [](auto& a, auto& b) { return a.first < b.first; });
+        auto& names = result[f.first];
+        for (auto& n : f.second)
+            if (std::find(names.begin(), names.end(), n.second) == names.end()) names.push_back(n.second);
+    }
+    return result;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Source scanning
+////////////////////////////////////////////////////////////////////////////////////////////
+bool IsSourceFile(const std::filesystem::path& path)
+{
+    static const std::set<std::string> extensions = { ".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".hxx", ".inl", ".m", ".mm" };
+
+    // These name every entry point there is, scanning them would keep everything
+    static const std::set<std::string> skipped = { "glext.h", "glcorearb.h", "glxext.h", "wglext.h", "glextl.h", "glextl_impl.cpp" };
+
+    return extensions.count(path.extension().string()) != 0 && skipped.count(path.filename().string()) == 0;
+}
+
+bool IsIdentifierChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Collects every glFoo identifier and every GL_FOO name, the latter so features named in glExtIsLoaded("GL_ARB_foo") are kept too
+void ScanIdentifiers(std::string_view text, std::set<std::string, std::less<>>& names)
+{
+    std::string_view::size_type i = 0;
+    while (i < text.size())
+    {
+        if (!IsIdentifierChar(text[i])) { i++; continue; }
+
+        std::string_view::size_type start = i;
+        while (i < text.size() && IsIdentifierChar(text[i])) i++;
+
+        std::string_view identifier = text.substr(start, i - start);
+        if (identifier.size() > 2 && identifier[0] == 'g' && identifier[1] == 'l' && identifier[2] >= 'A' && identifier[2] <= 'Z')
+            names.emplace(identifier);
+        else if (identifier.size() > 3 && identifier.compare(0, 3, "GL_") == 0)
+            names.emplace(identifier);
+    }
+}
+
+// Returns the number of files scanned
+size_t ScanSourceUsage(const std::vector<std::string>& folders, std::set<std::string, std::less<>>& names, int jobs)
+{
+    std::vector<std::string> files;
+    for (auto& folder : folders)
+    {
+        std::error_code error;
+        for (std::filesystem::recursive_directory_iterator it(folder, error), end; !error && it != end; it.increment(error))
+        {
+            if (it->is_regular_file(error) && IsSourceFile(it->path()))
+                files.push_back(it->path().string());
+        }
+        if (error) std::cout << "Unable to scan " << folder << ": " << error.message() << std::endl;
+    }
+
+    // Sort so the result does not depend on the order the file system hands them out
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::set<std::string, std::less<>>> found(files.size());
+    ParallelFor(files.size(), jobs, [&](size_t i)
+    {
+        MappedFile file(files[i]);
+        ScanIdentifiers(file.View(), found[i]);
+    });
+
+    for (auto& f : found) names.insert(f.begin(), f.end());
+
+    return files.size();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// GeneratorOptions implementation
+////////////////////////////////////////////////////////////////////////////////////////////
+GeneratorOptions::GeneratorOptions()
+    : api("gl"), majorVersion(-1), minorVersion(-1), profile("compatibility"), allExtensions(true), usedOnly(false), parts(-1), capture(false), nullBackend(false)
+{ }
+
+std::string GeneratorOptions::ToString() const
+{
+    std::string result = "api=" + this->api + ":" + std::to_string(this->majorVersion) + "." + std::to_string(this->minorVersion);
+    result += " profile=" + this->profile;
+    result += " extensions=";
+    if (this->allExtensions)
+        result += "*";
+    else
+        for (auto& extension : this->extensions) result += extension + ",";
+    if (this->parts >= 0) result += " parts=" + std::to_string(this->parts);
+    if (this->capture) result += " capture";
+    if (this->nullBackend) result += " null";
+    if (!this->hot.empty())
+    {
+        result += " hot=";
+        for (auto& name : this->hot) result += name + ",";
+    }
+    if (this->usedOnly)
+    {
+        result += " used=";
+        for (auto& name : this->usedNames) result += name + ",";
+    }
+    return result;
+}
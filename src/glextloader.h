@@ -3,21 +3,46 @@
 
 #define MAX_EXTENSIONS 1024
 
+#include <functional>
 #include <map>
+#include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 
+// Read-only view of a whole file, memory mapped where the platform allows it.
+// All parsed records point into this mapping, so it must outlive them.
+class MappedFile
+{
+    const char* _data;
+    size_t _size;
+    bool _open;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#endif
+
+public:
+    MappedFile(const std::string& filename);
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator = (const MappedFile& other) = delete;
+    ~MappedFile();
+
+    bool IsOpen() const { return this->_open; }
+    std::string_view View() const { return std::string_view(this->_data, this->_size); }
+};
+
 class Prototype
 {
 public:
     Prototype();
     Prototype(const Prototype& other);
 
-    bool operator < (const Prototype other) const;
+    bool operator < (const Prototype& other) const;
 
-    std::string name;
-    std::string decl;
+    std::string_view name;
+    std::string_view decl;  // "<return> APIENTRY <name> (<params>)", "(void)" is written as "()"
 };
 
 class TypeDefinition
@@ -26,28 +51,56 @@ public:
     TypeDefinition();
     TypeDefinition(const TypeDefinition& other);
 
-    std::string name;
-    std::string returnType;
-    std::vector<std::string> params;
+    std::string_view name;
+    std::string_view returnType;
+    std::vector<std::string_view> params;
 };
 
 class Feature
 {
 public:
-    std::string name;
+    std::string_view name;
     std::map<Prototype, TypeDefinition> mapped;
 };
 
+// The names a core entry point is also known by in extensions, in the order they are tried
+typedef std::map<std::string_view, std::vector<std::string_view>> Aliases;
+
+// Decides which features and entry points end up in the generated loader
+class GeneratorOptions
+{
+public:
+    GeneratorOptions();
+
+    std::string api;                        // only "gl" for now
+    int majorVersion;                       // highest GL_VERSION_x_y to keep, -1 keeps all of them
+    int minorVersion;
+    std::string profile;                    // "compatibility" reads glext.h, "core" reads glcorearb.h
+    bool allExtensions;                     // when false, only the extensions listed below are kept
+    std::set<std::string, std::less<>> extensions;
+    bool usedOnly;                          // when true, only what is named in usedNames is kept
+    std::set<std::string, std::less<>> usedNames;          // gl* entry points and GL_* features found by ScanSourceUsage
+    int parts;                              // -1 keeps everything in glextl.h, 0 writes a file per feature, N writes N files
+    bool capture;                           // when true, the wrappers can record their calls for glExtReplay with GLEXTL_CAPTURE
+    bool nullBackend;                       // when true, glExtNullGetProc is written, a GL without a GPU for GLEXTL_NULL
+    std::vector<std::string> hot;           // entry points from a call profile, most called first, that go first in the output
+
+    // Everything that changes the output, in a stable form so it can be hashed
+    std::string ToString() const;
+};
+
+// Builds a tree of statements and scopes, and writes it out in one go into a single buffer.
+// Child writers are kept by reference, so they must live until Write is called.
 class Writer
 {
     class StatementChild
     {
     public:
-        StatementChild(Writer& scope);
-        StatementChild(const std::string& statement);
-        StatementChild(const std::string& statement, Writer& scope, int t = 2);
+        StatementChild(Writer& scope, int t);
+        StatementChild(std::string statement);
+        StatementChild(std::string statement, Writer& scope, int t = 2);
 
-        int _type;   // 0 == statement, 1 == scope, 2 == ifdef, 3 == ifndef
+        int _type;   // 0 == statement, 1 == scope, 2 == ifdef, 3 == ifndef, 4 == inline writer
         Writer& _scope;
         std::string _statement;
     };
@@ -55,19 +108,55 @@ class Writer
     std::vector<StatementChild> _children;
 
 public:
-    Writer& IfDef(const std::string& statement, Writer& child);
-    Writer& IfNotDef(const std::string& statement, Writer& child);
-    Writer& Statement(const std::string& statement);
+    Writer& IfDef(std::string statement, Writer& child);
+    Writer& IfNotDef(std::string statement, Writer& child);
+    Writer& Statement(std::string statement);
     Writer& Statement(const Writer& writer);
-    Writer& Statement(const std::vector<std::string>& statements);
+    Writer& Statement(std::vector<std::string> statements);
     Writer& EmptyLine();
     Writer& Enter(Writer& child);
 
-    void Write(std::ostream& out, int depth = 0) const;
+    void Write(std::string& out, int depth = 0) const;
+    void Write(std::ostream& out) const;
 
 };
 
-std::vector<Feature> LoadFeatures(std::ifstream& in);
-std::string WriteFeatures(const std::vector<Feature>& features);
+bool IsPrototype(std::string_view line);
+Prototype ReadPrototype(std::string_view line);
+bool IsTypeDefinition(std::string_view line);
+TypeDefinition ReadTypeDefinition(std::string_view line);
+std::map<Prototype, TypeDefinition> MapPrototypeToTypeDefinitions(const std::vector<Prototype>& prototypes, const std::vector<TypeDefinition>& typedefinitions);
+
+bool NextLine(std::string_view& text, std::string_view& line);
+std::vector<std::string_view> SplitFeatures(std::string_view header);
+std::vector<Feature> LoadFeatures(std::string_view header, int jobs = 1);
+bool ReadCallProfile(const std::string& filename, std::vector<std::string>& hot);
+std::string WriteFeatures(const std::vector<Feature>& features, const Aliases& aliases, int jobs = 1, bool implementations = true, bool capture = false, bool nullBackend = false, const std::vector<std::string>& hot = {});
+Writer WriteDeclarations(const std::vector<Feature>& features, const GeneratorOptions& options);
+Writer WriteImplementation(std::string implementation);
+void WriteHeader(std::string& out, Writer& declarations, Writer* implementation);
+std::vector<std::string> WriteFeatureIds(const std::vector<Feature>& features);
+std::string_view DispatchField(std::string_view name);
+std::string WriteDispatchTable(const std::vector<Feature>& features, const std::vector<std::string>& hot = {});
+std::string WriteDirectDispatch(const std::vector<Feature>& features, const std::vector<std::string>& hot = {});
+std::vector<std::string> WriteFeatureParts(const std::vector<Feature>& features, int parts, int jobs = 1, bool capture = false, const std::vector<std::string>& hot = {});
+std::vector<std::string> WriteFilterDeclarations();
+std::vector<std::string> WriteCaptureDeclarations();
+std::vector<std::string> WriteNullDeclarations();
+
+bool ParseVersionFeature(std::string_view name, int& major, int& minor);
+std::vector<Feature> FilterFeatures(std::vector<Feature> features, const GeneratorOptions& options);
+std::string SignatureOf(std::string_view decl);
+Aliases FindAliases(const std::vector<Feature>& features);
+size_t ScanSourceUsage(const std::vector<std::string>& folders, std::set<std::string, std::less<>>& names, int jobs = 1);
+
+unsigned long long HashBytes(std::string_view bytes, unsigned long long hash = 14695981039346656037ULL);
+unsigned long long ReadCacheFile(const std::string& filename, std::vector<std::string>& outputs);
+void WriteCacheFile(const std::string& filename, unsigned long long hash, const std::vector<std::string>& outputs);
+std::string ExecutablePath(const char* argv0);
+bool WriteFileIfChanged(const std::string& filename, const std::string& contents, bool& written);
+
+int DefaultJobCount();
+void ParallelFor(size_t count, int jobs, const std::function<void (size_t)>& body);
 
 #endif // GLEXTLOADER_H
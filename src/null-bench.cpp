@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#define GLEXTL_NULL
+#define GLEXTL_FILTER
+#define GLEXTL_IMPLEMENTATION
+#include <GL/glextl.h>
+
+#include "gl-utilities-shaders.h"
+#include "gl-utilities-textures.h"
+#include "gl-utilities-vertexbuffers.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Times the CPU side of the gl-utilities classes on the null backend of the loader, so it
+/// runs without a GPU. Every operation is listed with the GL calls it makes, without the state
+/// filter of the loader, and the frame again with it.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct vec3 { float x, y, z; };
+struct vec4 { float x, y, z, w; };
+
+static const std::string vertexShader = "#version 330\nin vec3 vertex;\nin vec4 color;\nvoid main() { gl_Position = vec4(vertex, 1.0); }\n";
+static const std::string fragmentShader = "#version 330\nout vec4 result;\nvoid main() { result = vec4(1.0); }\n";
+
+template <class Function>
+void Measure(const std::string& name, int repeat, Function function)
+{
+    unsigned long long calls = glExtNullCalls(nullptr);
+    auto start = Clock::now();
+    for (int i = 0; i < repeat; i++) function();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    calls = glExtNullCalls(nullptr) - calls;
+
+    std::cout << "    " << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(1) << seconds * 1e9 / repeat << " ns"
+              << std::setw(10) << std::setprecision(1) << double(calls) / repeat << " calls" << std::endl;
+}
+
+void FillCube(VertexBuffer<vec3, vec4>& buffer)
+{
+    buffer.color({ 1.0f, 0.5f, 0.25f, 1.0f });
+    for (int i = 0; i < 36; i++) buffer.vertex({ float(i & 1), float((i >> 1) & 1), float((i >> 2) & 1) });
+}
+
+int main(int argc, char* argv[])
+{
+    int repeat = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+
+    if (!glExtLoadAll(glExtNullGetProc))
+    {
+        std::cout << "Unable to load the null backend" << std::endl;
+        return 1;
+    }
+
+    std::cout << "gl-utilities on the null backend, " << repeat << " times each:" << std::endl;
+    glExtFilterEnable(GL_FALSE);
+
+    Measure("CompiledShader::compile", repeat, [&]()
+    {
+        CompiledShader shader;
+        shader.compile(vertexShader, fragmentShader);
+    });
+
+    Shader<vec3, vec4> shader;
+    shader.compile(vertexShader, fragmentShader);
+
+    float matrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    Measure("PVMShader::setupMatrices", repeat, [&]() { shader.setupMatrices(matrix, matrix, matrix); });
+
+    Measure("RenderableBuffer::setup", repeat, [&]()
+    {
+        VertexBuffer<vec3, vec4> buffer(shader);
+        FillCube(buffer);
+        buffer.setup();
+        buffer.cleanup();
+    });
+
+    VertexBuffer<vec3, vec4> cube(shader);
+    FillCube(cube);
+    cube.setup();
+    Measure("RenderableBuffer::render", repeat, [&]() { cube.render(); });
+
+    VertexBuffer<vec3, vec4> faces(shader);
+    FillCube(faces);
+    for (int i = 0; i < 6; i++) faces.addFace(i * 6, 6);
+    faces.setup();
+    Measure("RenderableBuffer::render, 6 faces", repeat, [&]() { faces.render(); });
+
+    Measure("Texture::setup and cleanup", repeat, [&]()
+    {
+        Texture texture;
+        texture.setup();
+        texture.cleanup();
+    });
+
+    Texture texture;
+    texture.setup();
+    Measure("Texture::use", repeat, [&]() { texture.use(); });
+
+    // A frame of a few objects that share the shader and the texture, the way a simple scene draws them
+    Measure("frame of 10 textured draws", repeat, [&]()
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            shader.setupMatrices(matrix, matrix, matrix);
+            texture.use();
+            cube.render();
+        }
+    });
+
+    glExtFilterEnable(GL_TRUE);
+    glExtFilterFrame();
+    Measure("frame of 10 textured draws, filtered", repeat, [&]()
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            shader.setupMatrices(matrix, matrix, matrix);
+            texture.use();
+            cube.render();
+        }
+    });
+
+    GLExtFilterCounts counts = glExtFilterFrame();
+    std::cout << "    " << std::setprecision(1) << double(counts.filtered) / repeat << " state changes filtered and "
+              << double(counts.forwarded) / repeat << " made per frame" << std::endl;
+
+    cube.cleanup();
+    faces.cleanup();
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "glextloader.h"
+#include <atomic>
+#include <thread>
+
+int DefaultJobCount()
+{
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? int(count) : 1;
+}
+
+void ParallelFor(size_t count, int jobs, const std::function<void (size_t)>& body)
+{
+    if (jobs > int(count)) jobs = int(count);
+
+    // Not worth starting threads for, do it on the calling thread
+    if (jobs <= 1)
+    {
+        for (size_t i = 0; i < count; i++) body(i);
+        return;
+    }
+
+    // Features differ a lot in size, so every worker takes the next index when it is done with the last
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++) body(i);
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < jobs; i++) workers.push_back(std::thread(worker));
+    worker();
+    for (auto& w : workers) w.join();
+}
@@ -1,8 +1,13 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include "glextloader.h"
 
 void printVersion();
 void printHelp();
+bool parseApi(const std::string& value, GeneratorOptions& options);
+void parseExtensions(const std::string& value, GeneratorOptions& options);
 
 int main(int argc, char* argv[])
 {
@@ -11,7 +16,7 @@ int main(int argc, char* argv[])
     if (argc == 1)
     {
         std::cout << "Too few arguments, I need atleast a source directory where I cn find glext.h." << std::endl;
-        return 0;
+        return 1;
     }
 
     if (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")
@@ -21,84 +26,236 @@ int main(int argc, char* argv[])
     }
 
     std::string sourcefolder = argv[1];
+    std::string targetfolder = argv[1];
+    std::string cachefile;
+    std::vector<std::string> scanfolders;
+    std::string profilefile;
+    GeneratorOptions options;
+
+    int jobs = DefaultJobCount();
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        // The options without a value
+        if (arg == "--capture" || arg == "--null")
+        {
+            if (arg == "--capture") options.capture = true;
+            else options.nullBackend = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cout << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+
+        if (arg == "--jobs" || arg == "-j")
+            jobs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--cache")
+            cachefile = argv[++i];
+        else if (arg == "--output" || arg == "-o")
+            targetfolder = argv[++i];
+        else if (arg == "--api")
+        {
+            if (!parseApi(argv[++i], options))
+            {
+                std::cout << "Unsupported api " << argv[i] << ", expected something like gl:4.5" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--profile")
+        {
+            options.profile = argv[++i];
+            if (options.profile != "core" && options.profile != "compatibility")
+            {
+                std::cout << "Unknown profile " << options.profile << ", expected core or compatibility" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--extensions")
+            parseExtensions(argv[++i], options);
+        else if (arg == "--scan")
+            scanfolders.push_back(argv[++i]);
+        else if (arg == "--order")
+            profilefile = argv[++i];
+        else if (arg == "--split")
+        {
+            std::string value = argv[++i];
+            options.parts = value == "features" ? 0 : std::atoi(value.c_str());
+            if (options.parts <= 0 && value != "features")
+            {
+                std::cout << "Expected a number of files or features for --split, not " << value << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            printHelp();
+            return 1;
+        }
+    }
+
+    // The core profile is generated from glcorearb.h, which leaves out everything that was removed from it like glFogCoordfv
+    std::string headerfile = sourcefolder + (options.profile == "core" ? "/include/GL/glcorearb.h" : "/include/GL/glext.h");
+    std::string glextl_h = targetfolder + "/include/GL/glextl.h";
+    std::string glextl_cpp = targetfolder + "/glextl_impl.cpp";
 
-    std::ifstream stream(sourcefolder + "\\include\\GL\\glext.h");
-    if (!stream.is_open())
+    // The parsed features point into this mapping, so keep it open until we are done writing
+    MappedFile header(headerfile);
+    if (!header.IsOpen())
     {
-        std::cout << "Unable to find " << sourcefolder << "\\include\\GL\\glext.h" << std::endl;
+        std::cout << "Unable to find " << headerfile << std::endl;
+        return 1;
+    }
+
+    // Find out what the application actually uses
+    if (!scanfolders.empty())
+    {
+        options.usedOnly = true;
+        size_t count = ScanSourceUsage(scanfolders, options.usedNames, jobs);
+        std::cout << int(options.usedNames.size()) << " gl names found in " << int(count) << " source files" << std::endl;
+    }
+
+    if (!profilefile.empty())
+    {
+        if (!ReadCallProfile(profilefile, options.hot))
+        {
+            std::cout << "Unable to open " << profilefile << std::endl;
+            return 1;
+        }
+        std::cout << int(options.hot.size()) << " called entry points found in " << profilefile << std::endl;
+    }
+
+    // Everything that has an effect on the output goes into the hash, including the generator itself
+    unsigned long long hash = HashBytes(header.View());
+    hash = HashBytes(options.ToString(), hash);
+    if (!cachefile.empty())
+    {
+        MappedFile generator(ExecutablePath(argv[0]));
+        if (generator.IsOpen())
+            hash = HashBytes(generator.View(), hash);
+        else
+        {
+            // Without the generator in the hash a new generator would keep the old output, so always generate
+            std::cout << "Unable to read the generator itself, not using " << cachefile << std::endl;
+            cachefile.clear();
+        }
+    }
+
+    // Only skip when every file written with this hash, including the split parts, is still there
+    std::vector<std::string> outputs;
+    if (!cachefile.empty() && ReadCacheFile(cachefile, outputs) == hash && !outputs.empty()
+            && std::all_of(outputs.begin(), outputs.end(), [](const std::string& output) { return MappedFile(output).IsOpen(); }))
+    {
+        std::cout << glextl_h << " is up to date" << std::endl;
         return 0;
     }
-    std::vector<Feature> features = LoadFeatures(stream);
-    stream.close();
+    outputs = { glextl_h, glextl_cpp };
+
+    std::vector<Feature> features = LoadFeatures(header.View(), jobs);
 
     if (features.size() == 0)
     {
-        std::cout << "No features found in " << sourcefolder << "\\include\\GL\\glext.h" << std::endl;
-        return 0;
+        std::cout << "No features found in " << headerfile << std::endl;
+        return 1;
     }
 
-    std::cout << int(features.size()) << " features loaded from "  << sourcefolder << "\\include\\GL\\glext.h" << std::endl;
+    std::cout << int(features.size()) << " features loaded from "  << headerfile << std::endl;
 
-    std::string targetfolder = argv[1];
+    // Aliases come from all features, so a core entry point can fall back on an extension that is not generated
+    Aliases aliases = FindAliases(features);
+    features = FilterFeatures(std::move(features), options);
+
+    size_t entryPoints = 0;
+    for (auto& feature : features) entryPoints += feature.mapped.size();
+    std::cout << int(features.size()) << " features with " << int(entryPoints) << " entry points left after filtering" << std::endl;
+
+    Writer declarations = WriteDeclarations(features, options);
 
-    // GLEXTL header file
-    std::ofstream glext_h((targetfolder + "\\include\\GL\\glextl.h").c_str());
-    if (!glext_h.is_open())
+    // GLEXTL header file, with only the declarations when the implementation goes in the separate files below
+    std::string output;
+    if (options.parts < 0)
     {
-        std::cout << "Unable to open " << targetfolder << "\\include\\GL\\glextl.h" << std::endl;
-        return 0;
+        Writer implementation = WriteImplementation(WriteFeatures(features, aliases, jobs, true, options.capture, options.nullBackend, options.hot));
+        WriteHeader(output, declarations, &implementation);
     }
+    else
+        WriteHeader(output, declarations, nullptr);
 
-    // GLEXTL header file
-    Writer()
-            // Write Declaration
-            .IfNotDef("GLEXTL_H", Writer()
-                      .Statement("#define GLEXTL_H")
-                      .Statement("#include <GL/gl.h>")
-                      .Statement("#define GL_GLEXT_PROTOTYPES")
-                      .Statement("#include <GL/glext.h>")
-                      .EmptyLine()
-                      .Statement("typedef void* (PFNGLGETPROC)(const GLubyte* name);")
-                      .EmptyLine()
-                      .Statement("GLboolean glExtLoadAll(PFNGLGETPROC* proc);")
-                      .Statement("GLboolean glExtLoadCore(PFNGLGETPROC* proc);")
-                      .Statement("GLboolean glExtLoadOne(PFNGLGETPROC* proc, const char* name);")
-                      .Statement("GLboolean glExtIsLoaded(const char* name);")
-                      .EmptyLine()
-                      )
-            .EmptyLine()
-
-            // Write implementation
-            .IfDef("GLEXTL_IMPLEMENTATION", Writer()
-                   .IfNotDef("_GLEXTL_IMPLEMENTATION_GUARD_", Writer()
-                             .Statement("#define _GLEXTL_IMPLEMENTATION_GUARD_")
-                             .Statement(WriteFeatures(features))
-                             )
-                   )
-            .Write(glext_h);
-
-    glext_h.close();
-
-    std::cout << features.size() << " features written to " << targetfolder << "\\include\\GL\\glextl.h" << std::endl;
-
-    // GLEXTL example implementation file
-    std::ofstream glext_cpp((targetfolder + "\\glextl_impl.cpp").c_str());
-    if (!glext_cpp.is_open())
-    {
-        std::cout << "Unable to open " << targetfolder << "\\glextl_impl.cpp" << std::endl;
-        return 0;
+    // Only touch the files when they change, so everything including them is not rebuild for nothing
+    bool written = false;
+    if (!WriteFileIfChanged(glextl_h, output, written))
+    {
+        std::cout << "Unable to open " << glextl_h << std::endl;
+        return 1;
     }
 
-    Writer()
-            .EmptyLine()
-            .Statement("#define GLEXTL_IMPLEMENTATION")
-            .Statement("#include <GL/glextl.h>")
-            .EmptyLine()
-            .Write(glext_cpp);
+    std::cout << features.size() << " features " << (written ? "written to " : "unchanged in ") << glextl_h << std::endl;
 
-    glext_cpp.close();
+    // GLEXTL example implementation file, or the load functions when the implementation is split up
+    output.clear();
+    if (options.parts < 0)
+    {
+        Writer()
+                .EmptyLine()
+                .Statement("#define GLEXTL_IMPLEMENTATION")
+                .Statement("#include <GL/glextl.h>")
+                .EmptyLine()
+                .Write(output);
+    }
+    else
+    {
+        Writer()
+                .Statement("#include <stdlib.h>")
+                .Statement("#include <stddef.h>")
+                .Statement("#include <stdio.h>")
+                .Statement("#include <string.h>")
+                .Statement("#include <GL/glextl.h>")
+                .EmptyLine()
+                .Statement(WriteFeatures(features, aliases, jobs, false, options.capture, options.nullBackend, options.hot))
+                .Write(output);
+    }
+
+    if (!WriteFileIfChanged(glextl_cpp, output, written))
+    {
+        std::cout << "Unable to open " << glextl_cpp << std::endl;
+        return 1;
+    }
+
+    std::cout << "Implementation file " << (written ? "written to " : "unchanged in ") << glextl_cpp << std::endl;
+
+    if (options.parts >= 0)
+    {
+        std::vector<std::string> parts = WriteFeatureParts(features, options.parts, jobs, options.capture, options.hot);
+
+        int count = 0;
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            output.clear();
+            Writer()
+                    .Statement("#include <GL/glextl.h>")
+                    .EmptyLine()
+                    .Statement("void* glExt_GetProcAddress(const GLubyte* name);")
+                    .Statement("void* glExt_ResolveProc(int i);")
+                    .EmptyLine()
+                    .Statement(std::move(parts[i]))
+                    .Write(output);
+
+            std::string filename = targetfolder + "/glextl_impl_" + std::to_string(i) + ".cpp";
+            if (!WriteFileIfChanged(filename, output, written))
+            {
+                std::cout << "Unable to open " << filename << std::endl;
+                return 1;
+            }
+            if (written) count++;
+            outputs.push_back(filename);
+        }
+
+        std::cout << int(parts.size()) << " implementation files glextl_impl_N.cpp in " << targetfolder << ", " << count << " of them written" << std::endl;
+    }
 
-    std::cout << "Example implementation file written to " << targetfolder << "\\glextl.cpp" << std::endl;
+    if (!cachefile.empty()) WriteCacheFile(cachefile, hash, outputs);
 
     return 0;
 }
@@ -110,5 +267,56 @@ void printVersion()
 
 void printHelp()
 {
-    std::cout << "Help?" << std::endl;
+    std::cout << "Usage: gl-utilities-extensions <source folder> [options]" << std::endl;
+    std::cout << "  --output DIR, -o DIR       folder to write include/GL/glextl.h and glextl_impl.cpp to (default: the source folder)" << std::endl;
+    std::cout << "  --api gl:X.Y               only keep the GL versions up to X.Y (default: all of them)" << std::endl;
+    std::cout << "  --profile core|compatibility" << std::endl;
+    std::cout << "                             core generates the loader from glcorearb.h instead of glext.h (default: compatibility)" << std::endl;
+    std::cout << "  --extensions A,B,...       only keep these extensions, an empty list keeps none (default: all of them)" << std::endl;
+    std::cout << "  --scan DIR                 only keep the gl* entry points used in the sources under DIR, and the features" << std::endl;
+    std::cout << "                             they come from or that are named as GL_*, can be given more than once" << std::endl;
+    std::cout << "  --split N|features         write a declarations only glextl.h, the load functions in glextl_impl.cpp and" << std::endl;
+    std::cout << "                             the features in N files of about the same size, or one file per feature," << std::endl;
+    std::cout << "                             named glextl_impl_0.cpp, glextl_impl_1.cpp and so on" << std::endl;
+    std::cout << "  --order FILE               put the entry points called in FILE first in the dispatch table and the wrappers," << std::endl;
+    std::cout << "                             most called first, FILE is a glExtProfileReport of a real run, as text or JSON" << std::endl;
+    std::cout << "  --capture                  let the wrappers record their calls with GLEXTL_CAPTURE, and write glExtReplay" << std::endl;
+    std::cout << "  --null                     write glExtNullGetProc, a GL without a GPU that counts calls, for GLEXTL_NULL" << std::endl;
+    std::cout << "  --jobs N, -j N             number of worker threads used for parsing and writing (default: all cores)" << std::endl;
+    std::cout << "  --cache FILE               remember a hash of the inputs and the files written in FILE, and skip generating when" << std::endl;
+    std::cout << "                             the inputs did not change and the files are still there" << std::endl;
+}
+
+// Reads "gl:4.5" or just "gl"
+bool parseApi(const std::string& value, GeneratorOptions& options)
+{
+    std::string::size_type separator = value.find(':');
+    if (value.substr(0, separator) != "gl") return false;
+
+    options.api = "gl";
+    options.majorVersion = -1;
+    options.minorVersion = -1;
+    if (separator == std::string::npos) return true;
+
+    int major = 0, minor = 0;
+    char dot = 0, rest = 0;
+    if (std::sscanf(value.c_str() + separator + 1, "%d%c%d%c", &major, &dot, &minor, &rest) != 3 || dot != '.')
+        return false;
+
+    options.majorVersion = major;
+    options.minorVersion = minor;
+    return true;
+}
+
+void parseExtensions(const std::string& value, GeneratorOptions& options)
+{
+    options.allExtensions = false;
+
+    std::string::size_type start = 0;
+    while (start <= value.size())
+    {
+        std::string::size_type end = std::min(value.find(',', start), value.size());
+        if (end > start) options.extensions.insert(value.substr(start, end - start));
+        start = end + 1;
+    }
 }
@@ -1,37 +1,47 @@
 #include "glextloader.h"
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 /// Forward declarations of helper methods
 ////////////////////////////////////////////////////////////////////////////////////////////
-std::vector<std::string> ParseParameters(std::string p);
-void replaceAll(std::string &s, const std::string &search, const std::string &replace);
+std::vector<std::string_view> ParseParameters(std::string_view p);
+bool StartsWith(std::string_view s, std::string_view prefix);
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 /// Prototype methods
 ////////////////////////////////////////////////////////////////////////////////////////////
-bool IsPrototype(const std::string& line)
+bool IsPrototype(std::string_view line)
 {
-    return line.substr(0, 6) == std::string("GLAPI ");
+    return StartsWith(line, "GLAPI ");
 }
 
-Prototype ReadPrototype(const std::string& line)
+Prototype ReadPrototype(std::string_view line)
 {
     Prototype p;
 
-    std::string::size_type pos = line.find("APIENTRY ") + std::string("APIENTRY ").size();
-    p.name = line.substr(pos, line.substr(pos).find_first_of(' '));
-
-    // Find the opening bracket for the parameters
-    pos = line.find_last_of('(') + 1;
+    std::string_view::size_type pos = line.find("APIENTRY ") + std::string_view("APIENTRY ").size();
+    p.name = line.substr(pos, line.find(' ', pos) - pos);
 
-    p.decl = line.substr(std::string("GLAPI ").size());
-    p.decl = p.decl.substr(0, p.decl.size() - 1);
-    if (p.decl.find("(void)") != std::string::npos)
-        replaceAll(p.decl, "(void)", "()");
+    // Everything after "GLAPI " without the closing semicolon
+    p.decl = line.substr(std::string_view("GLAPI ").size());
+    p.decl.remove_suffix(1);
 
     return p;
 }
@@ -39,21 +49,20 @@ Prototype ReadPrototype(const std::string& line)
 ////////////////////////////////////////////////////////////////////////////////////////////
 /// Type definition methods
 ////////////////////////////////////////////////////////////////////////////////////////////
-bool IsTypeDefinition(const std::string& line)
+bool IsTypeDefinition(std::string_view line)
 {
-    return line.substr(0, 8) == std::string("typedef ")
-            && line.find("(APIENTRYP ") != std::string::npos;
+    return StartsWith(line, "typedef ")
+            && line.find("(APIENTRYP ") != std::string_view::npos;
 }
 
-TypeDefinition ReadTypeDefinition(const std::string& line)
+TypeDefinition ReadTypeDefinition(std::string_view line)
 {
     TypeDefinition t;
 
-    std::string::size_type pos = line.find("(APIENTRYP ");
-    t.returnType = line.substr(std::string("typedef ").size(), pos - std::string("typedef ").size() - 1);
-    pos += std::string("(APIENTRYP ").size();
-    t.name = line.substr(pos, line.substr(pos).find(')'));
-
+    std::string_view::size_type pos = line.find("(APIENTRYP ");
+    t.returnType = line.substr(std::string_view("typedef ").size(), pos - std::string_view("typedef ").size() - 1);
+    pos += std::string_view("(APIENTRYP ").size();
+    t.name = line.substr(pos, line.find(')', pos) - pos);
 
     // Find the opening bracket for the parameters
     pos = line.find_last_of('(') + 1;
@@ -68,15 +77,24 @@ std::map<Prototype, TypeDefinition> MapPrototypeToTypeDefinitions(const std::vec
 {
     std::map<Prototype, TypeDefinition> result;
 
-    for (auto m : prototypes)
+    // Index the type definitions by name once, so every prototype is a single exact lookup
+    std::unordered_map<std::string_view, const TypeDefinition*> index;
+    index.reserve(typedefinitions.size());
+    for (auto& t : typedefinitions)
+        index.insert(std::make_pair(t.name, &t));
+
+    // The type definition of glFooBar is named PFNGLFOOBARPROC
+    std::string key;
+    for (auto& m : prototypes)
     {
-        std::string upper = m.name;
-        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-        for (auto t : typedefinitions)
-        {
-            if (t.name.find(upper) != std::string::npos)
-                result.insert(std::make_pair(m, t));
-        }
+        key.assign("PFN");
+        key.append(m.name);
+        key.append("PROC");
+        std::transform(key.begin() + 3, key.end() - 4, key.begin() + 3, ::toupper);
+
+        auto found = index.find(key);
+        if (found != index.end())
+            result.insert(std::make_pair(m, *found->second));
     }
 
     return result;
@@ -86,22 +104,23 @@ std::map<Prototype, TypeDefinition> MapPrototypeToTypeDefinitions(const std::vec
 ////////////////////////////////////////////////////////////////////////////////////////////
 /// Feature methods
 ////////////////////////////////////////////////////////////////////////////////////////////
-bool IsFeatureStart(const std::string& line)
+bool IsFeatureStart(std::string_view line)
 {
-    return line.substr(0, 11) == std::string("#ifndef GL_");
+    return StartsWith(line, "#ifndef GL_");
 }
 
-bool IsFeatureEnd(const std::string& line)
+bool IsFeatureEnd(std::string_view line)
 {
-    return line.substr(0, 13) == std::string("#endif /* GL_");
+    return StartsWith(line, "#endif /* GL_");
 }
 
-bool LoadFeature(Feature& feature, std::ifstream& in, std::string line)
+bool LoadFeature(Feature& feature, std::string_view& text)
 {
     std::vector<Prototype> prototypes;
     std::vector<TypeDefinition> typeDefinitions;
+    std::string_view line;
 
-    do
+    while (NextLine(text, line))
     {
         if (IsFeatureStart(line))
         {
@@ -123,72 +142,269 @@ bool LoadFeature(Feature& feature, std::ifstream& in, std::string line)
             return true;
         }
     }
-    while (std::getline(in, line));
 
-    // We are at the end of the stream, but have not found the end of the feature yet. This is an error situation
+    // We are at the end of the text, but have not found the end of the feature yet. This is an error situation
     return false;
 }
 
-std::vector<Feature> LoadFeatures(std::ifstream& in)
+// Cuts the header into one piece per feature, each running up to and including its "#endif /* GL_" line
+std::vector<std::string_view> SplitFeatures(std::string_view header)
 {
-    std::vector<Feature> result;
-    std::string line;
+    std::vector<std::string_view> result;
+    std::string_view text = header, line;
+    const char* start = header.data();
 
-    while (std::getline(in, line))
+    while (NextLine(text, line))
     {
-        Feature feature;
-        if (LoadFeature(feature, in, line))
-            result.push_back(feature);
+        if (IsFeatureEnd(line))
+        {
+            result.push_back(std::string_view(start, size_t(text.data() - start)));
+            start = text.data();
+        }
     }
 
     return result;
 }
 
+std::vector<Feature> LoadFeatures(std::string_view header, int jobs)
+{
+    std::vector<std::string_view> chunks = SplitFeatures(header);
+    std::vector<Feature> result(chunks.size());
+
+    ParallelFor(chunks.size(), jobs, [&](size_t i)
+    {
+        std::string_view chunk = chunks[i];
+        LoadFeature(result[i], chunk);
+    });
+
+    return result;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Call profile methods
+////////////////////////////////////////////////////////////////////////////////////////////
+// Reads the name and calls of one entry of glExtProfileReport, a line of its text table or of its JSON array
+bool ReadProfileEntry(std::string_view line, std::string_view& name, unsigned long long& calls)
+{
+    std::string_view::size_type pos = line.find("\"name\": \"");
+    if (pos != std::string_view::npos)
+    {
+        pos += std::string_view("\"name\": \"").size();
+        name = line.substr(pos, line.find('"', pos) - pos);
+        pos = line.find("\"calls\": ");
+        if (pos == std::string_view::npos) return false;
+        line.remove_prefix(pos + std::string_view("\"calls\": ").size());
+    }
+    else
+    {
+        pos = line.find_first_not_of(' ');
+        if (pos == std::string_view::npos) return false;
+        line.remove_prefix(pos);
+        name = line.substr(0, line.find(' '));
+        line.remove_prefix(name.size());
+        line.remove_prefix(std::min(line.find_first_not_of(' '), line.size()));
+    }
+
+    if (!StartsWith(name, "gl") || line.empty() || line.front() < '0' || line.front() > '9') return false;
+    calls = std::strtoull(std::string(line.substr(0, line.find_first_not_of("0123456789"))).c_str(), nullptr, 10);
+    return true;
+}
+
+// The entry points of a call profile that were called, most called first. The same entry point in more than one
+// line, like in reports of several runs put together, has its calls added up.
+bool ReadCallProfile(const std::string& filename, std::vector<std::string>& hot)
+{
+    MappedFile file(filename);
+    if (!file.IsOpen()) return false;
+
+    std::map<std::string, unsigned long long, std::less<>> calls;
+    std::string_view text = file.View(), line, name;
+    unsigned long long count = 0;
+    while (NextLine(text, line))
+    {
+        if (ReadProfileEntry(line, name, count) && count > 0)
+            calls[std::string(name)] += count;
+    }
+
+    std::vector<std::pair<std::string, unsigned long long>> sorted(calls.begin(), calls.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.second > b.second; });
+
+    hot.clear();
+    for (auto& entry : sorted) hot.push_back(entry.first);
+    return true;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 /// Helper methods
 ////////////////////////////////////////////////////////////////////////////////////////////
-void replaceAll(std::string &s, const std::string &search, const std::string &replace)
+bool StartsWith(std::string_view s, std::string_view prefix)
+{
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Splits the next line off the front of text, without the line ending
+bool NextLine(std::string_view& text, std::string_view& line)
+{
+    if (text.empty()) return false;
+
+    std::string_view::size_type end = text.find('\n');
+    if (end == std::string_view::npos)
+    {
+        line = text;
+        text.remove_prefix(text.size());
+    }
+    else
+    {
+        line = text.substr(0, end);
+        text.remove_prefix(end + 1);
+    }
+
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    return true;
+}
+
+// 64 bit FNV-1a, pass the previous hash to continue hashing over more than one input
+unsigned long long HashBytes(std::string_view bytes, unsigned long long hash)
 {
-    for(auto pos = 0; ; pos += replace.length())
+    for (auto c : bytes)
     {
-        // Locate the substring to replace
-        pos = s.find( search, pos);
-        if(pos == std::string::npos) break;
-        // Replace by erasing and inserting
-        s.erase(pos, search.length());
-        s.insert(pos, replace);
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
     }
+    return hash;
 }
 
-std::vector<std::string> ParseParameters(std::string p)
+// The hash on the first line, followed by the files that were written for it, one per line
+unsigned long long ReadCacheFile(const std::string& filename, std::vector<std::string>& outputs)
 {
-    std::vector<std::string> r;
+    unsigned long long hash = 0;
+    std::ifstream in(filename.c_str());
+    if (!(in >> std::hex >> hash)) return 0;
 
-    // Make sure we end with a comma, otherwise the last item is not parsed
-    p += ",";
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line))
+        if (!line.empty()) outputs.push_back(line);
+    return hash;
+}
+
+// The file the generator runs from. argv[0] is only a usable path when the generator was not found through PATH,
+// so ask the platform first, and return an empty string when neither works.
+std::string ExecutablePath(const char* argv0)
+{
+#if defined(_WIN32)
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+    if (length > 0 && length < MAX_PATH) return std::string(path, length);
+#elif defined(__APPLE__)
+    char path[4096];
+    uint32_t size = sizeof(path);
+    if (_NSGetExecutablePath(path, &size) == 0) return path;
+#else
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path));
+    if (length > 0 && length < ssize_t(sizeof(path))) return std::string(path, size_t(length));
+#endif
+    std::string_view name = argv0 != nullptr ? argv0 : "";
+    return name.find_first_of("/\\") != std::string_view::npos ? std::string(name) : std::string();
+}
+
+std::vector<std::string_view> ParseParameters(std::string_view p)
+{
+    std::vector<std::string_view> r;
 
-    while (p.find_first_of(",") != std::string::npos)
+    std::string_view::size_type pos = 0;
+    while (pos <= p.size())
     {
         // Trim the white spaces in front
-        p = p.substr(p.find_first_not_of(' '));
+        pos = std::min(p.find_first_not_of(' ', pos), p.size());
 
-        // Determine the key=value pair
-        std::string kvp = p.substr(0, p.find_first_of(",)["));
-        std::string key = kvp.substr(kvp.find_last_of("* ") + 1);
+        // Determine the key=value pair, ending at the next comma or at the end of the list
+        std::string_view kvp = p.substr(pos, p.find_first_of(",)[", pos) - pos);
+        std::string_view key = kvp.substr(kvp.find_last_of("* ") + 1);
 
         // Add the parameter to our list
         if (key != "void")
             r.push_back(key);
 
-        // Remove the parameter we just added from the parameter string
-        p = p.substr(p.find_first_of(",)") + 1);
+        // Skip past the parameter we just added
+        std::string_view::size_type next = p.find_first_of(",)", pos);
+        if (next == std::string_view::npos) break;
+        pos = next + 1;
     }
 
     return r;
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////
+/// MappedFile implementation
+////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& filename)
+    : _data(nullptr), _size(0), _open(false), _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+{
+    this->_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->_file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(this->_file, &size)) return;
+
+    this->_open = true;
+    if (size.QuadPart == 0) return;
+
+    this->_mapping = CreateFileMappingA(this->_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->_mapping == nullptr) { this->_open = false; return; }
+
+    this->_data = static_cast<const char*>(MapViewOfFile(this->_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->_data == nullptr) { this->_open = false; return; }
+
+    this->_size = size_t(size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+    if (this->_data != nullptr) UnmapViewOfFile(this->_data);
+    if (this->_mapping != nullptr) CloseHandle(this->_mapping);
+    if (this->_file != INVALID_HANDLE_VALUE) CloseHandle(this->_file);
+}
+#else
+MappedFile::MappedFile(const std::string& filename)
+    : _data(nullptr), _size(0), _open(false)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+    {
+        this->_open = true;
+        if (st.st_size > 0)
+        {
+            void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                this->_data = static_cast<const char*>(data);
+                this->_size = size_t(st.st_size);
+            }
+            else
+                this->_open = false;
+        }
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (this->_data != nullptr) munmap(const_cast<char*>(this->_data), this->_size);
+}
+#endif
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 /// Prototype and TypeDefinition implementation
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -198,7 +414,7 @@ Prototype::Prototype(const Prototype& p)
     : name(p.name), decl(p.decl)
 { }
 
-bool Prototype::operator < (const Prototype other) const
+bool Prototype::operator < (const Prototype& other) const
 {
     return this->name < other.name;
 }
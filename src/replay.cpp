@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define GLEXTL_CAPTURE
+#define GLEXTL_NULL
+#define GLEXTL_IMPLEMENTATION
+#include <GL/glextl.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Lists what is in a stream recorded with GLEXTL_CAPTURE and times its decoding. The tool has
+/// no window or context of its own: without a GL backend the calls are decoded but not made,
+/// and with --null they are made on the null backend of the loader. To play a stream on a GPU,
+/// call glExtReplay from the application with its context current.
+////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+class EntryPointStats
+{
+public:
+    std::string name;
+    unsigned long long calls = 0;
+    unsigned long long bytes = 0;
+};
+
+bool ReadStream(const std::string& filename, std::vector<unsigned char>& stream)
+{
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in) return false;
+    stream.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Walks the records like glExtReplay does, and counts the calls and bytes of every entry point in the stream
+bool CountCalls(const std::vector<unsigned char>& stream, std::vector<EntryPointStats>& stats)
+{
+    unsigned int header[3];
+    if (stream.size() < 16 || std::memcmp(stream.data(), "GLXC", 4) != 0) return false;
+    std::memcpy(header, stream.data() + 4, sizeof(header));
+    if (header[0] != 2 || header[2] < 16 || header[2] > stream.size() || header[1] > header[2] - 16) return false;
+
+    const char* name = (const char*)stream.data() + 16;
+    const char* names = (const char*)stream.data() + header[2];
+    stats.resize(header[1]);
+    for (auto& s : stats)
+    {
+        const char* end = name < names ? (const char*)std::memchr(name, 0, size_t(names - name)) : nullptr;
+        if (end == nullptr) return false;
+        s.name.assign(name, end);
+        name = end + 1;
+    }
+
+    size_t pos = header[2];
+    while (pos < stream.size())
+    {
+        unsigned int record[2];
+        if (stream.size() - pos < sizeof(record)) return false;
+        std::memcpy(record, stream.data() + pos, sizeof(record));
+        if (record[0] < sizeof(record) || record[0] > stream.size() - pos || record[1] >= header[1]) return false;
+
+        stats[record[1]].calls++;
+        stats[record[1]].bytes += record[0];
+        pos += record[0];
+    }
+    return true;
+}
+
+void PrintStats(std::vector<EntryPointStats> stats)
+{
+    stats.erase(std::remove_if(stats.begin(), stats.end(), [](auto& s) { return s.calls == 0; }), stats.end());
+    std::stable_sort(stats.begin(), stats.end(), [](auto& a, auto& b) { return a.calls > b.calls; });
+
+    std::cout << std::left << std::setw(48) << "entry point" << std::right << std::setw(12) << "calls" << std::setw(14) << "bytes" << std::endl;
+    for (auto& s : stats)
+        std::cout << std::left << std::setw(48) << s.name << std::right << std::setw(12) << s.calls << std::setw(14) << s.bytes << std::endl;
+}
+
+void printHelp()
+{
+    std::cout << "Usage: gl-utilities-replay <capture file> [options]" << std::endl;
+    std::cout << "Decodes the stream without a GL context. Call glExtReplay from an application to draw it on a GPU." << std::endl;
+    std::cout << "  --repeat N                 decode the stream N times and report the time per pass (default: 1)" << std::endl;
+    std::cout << "  --stats                    list the calls in the stream by entry point, most first" << std::endl;
+    std::cout << "  --null                     make the calls on the null backend, which only counts them" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")
+    {
+        printHelp();
+        return 0;
+    }
+
+    std::string filename = argv[1];
+    int repeat = 1;
+    bool stats = false;
+    bool null = false;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--stats")
+            stats = true;
+        else if (arg == "--null")
+            null = true;
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<unsigned char> stream;
+    if (!ReadStream(filename, stream))
+    {
+        std::cout << "Unable to open " << filename << std::endl;
+        return 1;
+    }
+
+    std::vector<EntryPointStats> calls;
+    if (!CountCalls(stream, calls))
+    {
+        std::cout << filename << " is not a capture stream, or it is broken" << std::endl;
+        return 1;
+    }
+
+    unsigned long long records = 0;
+    for (auto& s : calls) records += s.calls;
+    std::cout << filename << ": " << stream.size() << " bytes, " << records << " calls" << std::endl;
+    if (stats) PrintStats(calls);
+
+    if (null)
+    {
+        glExtLoadAll(glExtNullGetProc);
+        glExtNullReset();
+    }
+
+    double best = 0.0;
+    for (int i = 0; i < repeat; i++)
+    {
+        auto start = Clock::now();
+        long long replayed = glExtReplay(stream.data(), GLsizeiptr(stream.size()));
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (replayed < 0)
+        {
+            std::cout << "Decoding stopped at a broken record" << std::endl;
+            return 1;
+        }
+        if (i == 0 || seconds < best) best = seconds;
+    }
+
+    std::cout << (null ? "Played back " : "Decoded ") << repeat << " times, best " << std::fixed << std::setprecision(3) << best * 1000.0 << " ms, "
+              << std::setprecision(1) << double(records) / std::max(best, 1e-9) / 1000000.0 << " million calls/s" << std::endl;
+    if (null) std::cout << glExtNullCalls(nullptr) / (unsigned long long)repeat << " calls made per playback" << std::endl;
+    return 0;
+}
@@ -1,121 +1,2632 @@
 #include "glextloader.h"
-#include <sstream>
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <set>
 
-std::string writeTabs(int count)
+void writeTabs(std::string& out, int count)
 {
-    std::stringstream out;
-    for (int i = 0; i < count; i++) out << "    ";
-    return out.str();
+    out.append(size_t(count) * 4, ' ');
 }
 
-std::string join(const std::string& separator, const std::vector<std::string>& values)
+// Appends all parts to out, without any temporary strings in between
+template <class... Parts>
+void append(std::string& out, const Parts&... parts)
 {
-    std::string result;
-    for (auto k : values) result += (k != values.front() ? ", " : "") + k;
+    (out.append(parts), ...);
+}
+
+void join(std::string& out, const std::string& separator, const std::vector<std::string_view>& values)
+{
+    for (auto& k : values)
+    {
+        if (&k != &values.front()) out.append(separator);
+        out.append(k);
+    }
+}
+
+// Prototypes are stored as they appear in glext.h, but we write "(void)" as "()"
+void writeDeclaration(std::string& out, std::string_view decl)
+{
+    static const std::string_view voidParams("(void)");
+
+    if (decl.size() >= voidParams.size() && decl.compare(decl.size() - voidParams.size(), voidParams.size(), voidParams) == 0)
+    {
+        decl.remove_suffix(voidParams.size());
+        append(out, decl, "()");
+    }
+    else
+        out.append(decl);
+}
+
+// The return type as written in front of APIENTRY, "const GLubyte *" for glGetString
+std::string_view returnTypeOf(std::string_view decl)
+{
+    std::string_view type = decl.substr(0, decl.find("APIENTRY"));
+    while (!type.empty() && type.back() == ' ') type.remove_suffix(1);
+    return type;
+}
+
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+    return s;
+}
+
+// The index of the first entry point of every feature in __glExtProcs, which is also what GLEXTL_PROFILE counts by
+std::vector<size_t> FirstEntryPoints(const std::vector<Feature>& features)
+{
+    std::vector<size_t> result;
+    size_t count = 0;
+    for (auto& feature : features)
+    {
+        result.push_back(count);
+        count += feature.mapped.size();
+    }
     return result;
 }
 
-std::string WriteFullFeature(Feature feature)
+////////////////////////////////////////////////////////////////////////////////////////////
+/// State filter
+////////////////////////////////////////////////////////////////////////////////////////////
+// The state GLEXTL_FILTER keeps per context, every value gets a slot in the shadow state. Element array buffers are
+// part of the vertex array, transform feedback buffers of the transform feedback object, so only the first is tracked.
+static const std::string_view filterBuffers[] = {
+    "GL_ARRAY_BUFFER", "GL_ELEMENT_ARRAY_BUFFER", "GL_PIXEL_PACK_BUFFER", "GL_PIXEL_UNPACK_BUFFER", "GL_UNIFORM_BUFFER",
+    "GL_TEXTURE_BUFFER", "GL_COPY_READ_BUFFER", "GL_COPY_WRITE_BUFFER", "GL_DRAW_INDIRECT_BUFFER", "GL_SHADER_STORAGE_BUFFER",
+    "GL_DISPATCH_INDIRECT_BUFFER", "GL_ATOMIC_COUNTER_BUFFER", "GL_QUERY_BUFFER",
+};
+
+static const std::string_view filterTextures[] = {
+    "GL_TEXTURE_1D", "GL_TEXTURE_2D", "GL_TEXTURE_3D", "GL_TEXTURE_1D_ARRAY", "GL_TEXTURE_2D_ARRAY", "GL_TEXTURE_RECTANGLE",
+    "GL_TEXTURE_CUBE_MAP", "GL_TEXTURE_CUBE_MAP_ARRAY", "GL_TEXTURE_BUFFER", "GL_TEXTURE_2D_MULTISAMPLE", "GL_TEXTURE_2D_MULTISAMPLE_ARRAY",
+};
+
+// The enables of the whole context, GL_TEXTURE_2D and friends of the old pipeline are per texture unit and not tracked
+static const std::string_view filterCaps[] = {
+    "GL_BLEND", "GL_CULL_FACE", "GL_DEPTH_TEST", "GL_STENCIL_TEST", "GL_SCISSOR_TEST", "GL_DITHER", "GL_MULTISAMPLE",
+    "GL_SAMPLE_ALPHA_TO_COVERAGE", "GL_SAMPLE_COVERAGE", "GL_POLYGON_OFFSET_FILL", "GL_POLYGON_OFFSET_LINE", "GL_LINE_SMOOTH",
+    "GL_DEPTH_CLAMP", "GL_FRAMEBUFFER_SRGB", "GL_PRIMITIVE_RESTART", "GL_PRIMITIVE_RESTART_FIXED_INDEX", "GL_RASTERIZER_DISCARD",
+    "GL_PROGRAM_POINT_SIZE", "GL_TEXTURE_CUBE_MAP_SEAMLESS", "GL_DEBUG_OUTPUT_SYNCHRONOUS",
+};
+
+// The entry points with a filter function, without their gl prefix. The bind and enable calls are dropped when they
+// change nothing, the others are always made and only keep the shadow state right.
+struct FilterHook
+{
+    std::string_view name;
+    std::string_view params;
+};
+
+static const FilterHook filterHooks[] = {
+    { "UseProgram", "GLuint program" },
+    { "BindVertexArray", "GLuint array" },
+    { "BindBuffer", "GLenum target, GLuint buffer" },
+    { "BindBufferBase", "GLenum target, GLuint index, GLuint buffer" },
+    { "BindBufferRange", "GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size" },
+    { "BindBuffersBase", "GLenum target, GLuint first, GLsizei count, const GLuint* buffers" },
+    { "BindBuffersRange", "GLenum target, GLuint first, GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizeiptr* sizes" },
+    { "ActiveTexture", "GLenum texture" },
+    { "BindTexture", "GLenum target, GLuint texture" },
+    { "BindTextureUnit", "GLuint unit, GLuint texture" },
+    { "BindTextures", "GLuint first, GLsizei count, const GLuint* textures" },
+    { "Enable", "GLenum cap" },
+    { "Disable", "GLenum cap" },
+    { "Enablei", "GLenum target, GLuint index" },
+    { "Disablei", "GLenum target, GLuint index" },
+    { "DeleteBuffers", "GLsizei n, const GLuint* buffers" },
+    { "DeleteVertexArrays", "GLsizei n, const GLuint* arrays" },
+    { "DeleteTextures", "GLsizei n, const GLuint* textures" },
+};
+
+// The hooks that are GL 1.0 and 1.1 functions, which the compatibility profile takes from gl.h without a wrapper
+static const std::string_view filterLegacyHooks[] = { "BindTexture", "Enable", "Disable", "DeleteTextures" };
+
+// The filter function of an entry point, or nothing. The ARB and EXT versions of a core function change the same
+// state with the same arguments, so they share its filter.
+std::string_view FilterOf(std::string_view name)
+{
+    if (name.compare(0, 2, "gl") != 0) return std::string_view();
+    name.remove_prefix(2);
+    for (std::string_view suffix : { "ARB", "EXT" })
+        if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+            name.remove_suffix(suffix.size());
+
+    for (auto& hook : filterHooks)
+        if (hook.name == name) return hook.name;
+    return std::string_view();
+}
+
+// The legacy hooks that none of the features has a wrapper for, they get a wrapper of their own around the gl.h function
+std::vector<const FilterHook*> UnwrappedHooks(const std::vector<Feature>& features)
+{
+    std::vector<const FilterHook*> out;
+    for (auto& hook : filterHooks)
+    {
+        if (std::find(std::begin(filterLegacyHooks), std::end(filterLegacyHooks), hook.name) == std::end(filterLegacyHooks)) continue;
+        bool wrapped = std::any_of(features.begin(), features.end(), [&](auto& feature)
+        {
+            return std::any_of(feature.mapped.begin(), feature.mapped.end(), [&](auto& mappedPrototype)
+            {
+                std::string_view name = mappedPrototype.first.name;
+                return name.size() == hook.name.size() + 2 && name.compare(2, std::string_view::npos, hook.name) == 0;
+            });
+        });
+        if (!wrapped) out.push_back(&hook);
+    }
+    return out;
+}
+
+// The parameter names of a hook, "target, texture" for "GLenum target, GLuint texture"
+std::string HookArguments(const FilterHook& hook)
+{
+    std::string out;
+    std::string_view params = hook.params;
+    while (!params.empty())
+    {
+        std::string_view p = trim(params.substr(0, params.find(',')));
+        params.remove_prefix(std::min(params.size(), params.find(',') == std::string_view::npos ? params.size() : params.find(',') + 1));
+        append(out, (out.empty() ? "" : ", "), p.substr(p.find_last_of("* ") + 1));
+    }
+    return out;
+}
+
+// The shadow state in every context, for the declarations in glextl.h. Names and units start out at
+// GLEXTL_FILTER_UNKNOWN and enables at 0xff, which never match a call.
+std::string WriteFilterState()
+{
+    std::string out;
+    append(out, "#define GLEXTL_FILTER_BUFFERS ", std::to_string(std::size(filterBuffers)), "\n");
+    append(out, "#define GLEXTL_FILTER_TARGETS ", std::to_string(std::size(filterTextures)), "\n");
+    append(out, "#define GLEXTL_FILTER_CAPS ", std::to_string(std::size(filterCaps)), "\n");
+    out.append("#define GLEXTL_FILTER_UNITS 32\n");
+    out.append("#define GLEXTL_FILTER_UNKNOWN 0xffffffffu\n");
+    out.append("struct GLExtFilterState\n{\n");
+    out.append("    GLboolean valid;\n");
+    out.append("    GLboolean bypass;\n");
+    out.append("    GLuint program;\n");
+    out.append("    GLuint vertexArray;\n");
+    out.append("    GLuint activeTexture;\n");
+    out.append("    GLuint buffers[GLEXTL_FILTER_BUFFERS];\n");
+    out.append("    GLuint textures[GLEXTL_FILTER_UNITS][GLEXTL_FILTER_TARGETS];\n");
+    out.append("    GLubyte enables[GLEXTL_FILTER_CAPS];\n");
+    out.append("    unsigned long long filtered;\n");
+    out.append("    unsigned long long forwarded;\n");
+    out.append("};\n\n");
+    return out;
+}
+
+// The declarations of the state filter for glextl.h. The gl.h functions among the hooks become macros for their
+// wrapper, so the compatibility profile filters them too.
+std::vector<std::string> WriteFilterDeclarations(const std::vector<Feature>& features)
+{
+    std::vector<std::string> out = {
+        "// Only with GLEXTL_FILTER defined for the implementation: glUseProgram, glBindVertexArray, glBindBuffer, glActiveTexture,",
+        "// glBindTexture, glEnable and glDisable are dropped when they would not change the state of the current context, as",
+        "// seen by the gl* functions since the last glExtFilterReset. Call it after changing that state some other way, like",
+        "// through GLEXTL_DIRECT_DISPATCH, another loader or the NV and APPLE versions of these functions. glExtFilterFrame",
+        "// returns the calls dropped and made since its last call, glExtFilterEnable(GL_FALSE) makes them all again.",
+        "// The compatibility profile takes glBindTexture, glEnable, glDisable and glDeleteTextures from gl.h, so they are",
+        "// macros for a wrapper here unless GLEXTL_DIRECT_DISPATCH is defined. Their address is still the unfiltered function.",
+        "struct GLExtFilterCounts { unsigned long long filtered; unsigned long long forwarded; };",
+        "struct GLExtFilterCounts glExtFilterFrame(void);",
+        "void glExtFilterReset(void);",
+        "void glExtFilterEnable(GLboolean enable);",
+    };
+    for (auto& hook : filterHooks)
+    {
+        std::string line;
+        append(line, "GLboolean glExt_Filter", hook.name, "(", hook.params, ");");
+        out.push_back(std::move(line));
+    }
+    out.insert(out.end(), {
+        "#ifdef GLEXTL_FILTER",
+        "#define GLEXTL_FILTER_CALL(name, args) if (!glExt_Filter##name args) return;",
+        "#else",
+        "#define GLEXTL_FILTER_CALL(name, args)",
+        "#endif",
+    });
+
+    auto unwrapped = UnwrappedHooks(features);
+    if (unwrapped.empty()) return out;
+    for (auto hook : unwrapped)
+    {
+        std::string line;
+        append(line, "void APIENTRY glExt_Filtered", hook->name, "(", hook->params, ");");
+        out.push_back(std::move(line));
+    }
+    out.push_back("#ifndef GLEXTL_DIRECT_DISPATCH");
+    for (auto hook : unwrapped)
+    {
+        std::string line, arguments = HookArguments(*hook);
+        append(line, "#define gl", hook->name, "(", arguments, ") glExt_Filtered", hook->name, "(", arguments, ")");
+        out.push_back(std::move(line));
+    }
+    out.push_back("#endif");
+    return out;
+}
+
+// The wrappers of the gl.h functions among the hooks, they call the function itself with its name in parentheses
+std::vector<std::string> WriteFilterWrappers(const std::vector<Feature>& features)
 {
-    std::stringstream out;
+    std::vector<std::string> out;
+    for (auto hook : UnwrappedHooks(features))
+    {
+        std::string line, arguments = HookArguments(*hook);
+        append(line, "void APIENTRY glExt_Filtered", hook->name, "(", hook->params, ") { GLEXTL_FILTER_CALL(", hook->name, ", (", arguments, ")) ");
+        append(line, "(gl", hook->name, ")(", arguments, "); }");
+        out.push_back(std::move(line));
+    }
+    return out;
+}
+
+// A switch from the GL enums to their slot in the shadow state, -1 for the ones that are not tracked
+void WriteFilterSlots(std::vector<std::string>& out, std::string_view function, const std::string_view* values, size_t count)
+{
+    std::string line;
+    append(line, "static int ", function, "(GLenum value)");
+    out.insert(out.end(), { line, "{", "    switch (value)", "    {" });
+    for (size_t i = 0; i < count; i++)
+    {
+        line.clear();
+        append(line, "    case ", values[i], ": return ", std::to_string(i), ";");
+        out.push_back(line);
+    }
+    out.insert(out.end(), { "    }", "    return -1;", "}", "" });
+}
+
+// The shadow state behind GLEXTL_FILTER. A wrapper asks its filter function whether to make the call, which updates
+// the state of the current context as if the call was made. GL errors are not checked, a call that fails with one
+// still changes the shadow state.
+std::vector<std::string> WriteFilter()
+{
+    std::vector<std::string> out;
+    WriteFilterSlots(out, "glExt_FilterBuffer", filterBuffers, std::size(filterBuffers));
+    WriteFilterSlots(out, "glExt_FilterTexture", filterTextures, std::size(filterTextures));
+    WriteFilterSlots(out, "glExt_FilterCap", filterCaps, std::size(filterCaps));
+
+    out.insert(out.end(), {
+        "void glExtFilterReset(void)",
+        "{",
+        "    struct GLExtFilterState* f = &__glExtCurrent->filter;",
+        "    f->program = f->vertexArray = f->activeTexture = GLEXTL_FILTER_UNKNOWN;",
+        "    memset(f->buffers, 0xff, sizeof(f->buffers));",
+        "    memset(f->textures, 0xff, sizeof(f->textures));",
+        "    memset(f->enables, 0xff, sizeof(f->enables));",
+        "    f->valid = GL_TRUE;",
+        "",
+        "    // Texture binds go to the active unit, so it is read once here instead of waiting for a glActiveTexture",
+        "    PFNGLEXTGETINTEGERVPROC getIntegerv = (PFNGLEXTGETINTEGERVPROC)glExt_GetProcAddress((const GLubyte*)\"glGetIntegerv\");",
+        "#ifndef __glcorearb_h_",
+        "    if (getIntegerv == 0) getIntegerv = glGetIntegerv;",
+        "#endif",
+        "    GLint unit = 0;",
+        "    if (getIntegerv != 0) getIntegerv(GL_ACTIVE_TEXTURE, &unit);",
+        "    if (unit >= GL_TEXTURE0) f->activeTexture = (GLuint)(unit - GL_TEXTURE0);",
+        "}",
+        "",
+        "void glExtFilterEnable(GLboolean enable)",
+        "{",
+        "    __glExtCurrent->filter.bypass = (GLboolean)!enable;",
+        "}",
+        "",
+        "struct GLExtFilterCounts glExtFilterFrame(void)",
+        "{",
+        "    struct GLExtFilterState* f = &__glExtCurrent->filter;",
+        "    struct GLExtFilterCounts counts;",
+        "    counts.filtered = f->filtered;",
+        "    counts.forwarded = f->forwarded;",
+        "    f->filtered = f->forwarded = 0;",
+        "    return counts;",
+        "}",
+        "",
+        "// A new context knows nothing until its first filtered call",
+        "static struct GLExtFilterState* glExt_FilterState(void)",
+        "{",
+        "    if (!__glExtCurrent->filter.valid) glExtFilterReset();",
+        "    return &__glExtCurrent->filter;",
+        "}",
+        "",
+        "// Counts the call, and tells the wrapper whether to make it",
+        "static GLboolean glExt_FilterCount(struct GLExtFilterState* f, GLboolean changed)",
+        "{",
+        "    GLboolean forward = (GLboolean)(changed || f->bypass);",
+        "    if (forward) f->forwarded++;",
+        "    else f->filtered++;",
+        "    return forward;",
+        "}",
+        "",
+        "// Deleting a bound object binds zero in its place",
+        "static void glExt_FilterUnbind(GLuint* bound, size_t count, GLsizei n, const GLuint* names)",
+        "{",
+        "    for (GLsizei i = 0; names != 0 && i < n; i++)",
+        "        for (size_t j = 0; j < count; j++)",
+        "            if (names[i] != 0 && bound[j] == names[i]) bound[j] = 0;",
+        "}",
+        "",
+        "GLboolean glExt_FilterUseProgram(GLuint program)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    GLboolean changed = (GLboolean)(f->program != program);",
+        "    f->program = program;",
+        "    return glExt_FilterCount(f, changed);",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindVertexArray(GLuint array)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    GLboolean changed = (GLboolean)(f->vertexArray != array);",
+        "    if (changed) f->buffers[glExt_FilterBuffer(GL_ELEMENT_ARRAY_BUFFER)] = GLEXTL_FILTER_UNKNOWN;",
+        "    f->vertexArray = array;",
+        "    return glExt_FilterCount(f, changed);",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindBuffer(GLenum target, GLuint buffer)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    int slot = glExt_FilterBuffer(target);",
+        "    if (slot < 0) return glExt_FilterCount(f, GL_TRUE);",
+        "    GLboolean changed = (GLboolean)(f->buffers[slot] != buffer);",
+        "    f->buffers[slot] = buffer;",
+        "    return glExt_FilterCount(f, changed);",
+        "}",
+        "",
+        "// The indexed binds also bind the buffer to the generic binding point of the target",
+        "GLboolean glExt_FilterBindBufferBase(GLenum target, GLuint index, GLuint buffer)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    int slot = glExt_FilterBuffer(target);",
+        "    (void)index;",
+        "    if (slot >= 0) f->buffers[slot] = buffer;",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)",
+        "{",
+        "    (void)offset;",
+        "    (void)size;",
+        "    return glExt_FilterBindBufferBase(target, index, buffer);",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindBuffersBase(GLenum target, GLuint first, GLsizei count, const GLuint* buffers)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    int slot = glExt_FilterBuffer(target);",
+        "    (void)first;",
+        "    (void)count;",
+        "    (void)buffers;",
+        "    if (slot >= 0) f->buffers[slot] = GLEXTL_FILTER_UNKNOWN;",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindBuffersRange(GLenum target, GLuint first, GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizeiptr* sizes)",
+        "{",
+        "    (void)offsets;",
+        "    (void)sizes;",
+        "    return glExt_FilterBindBuffersBase(target, first, count, buffers);",
+        "}",
+        "",
+        "GLboolean glExt_FilterActiveTexture(GLenum texture)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    GLuint unit = (GLuint)(texture - GL_TEXTURE0);",
+        "    GLboolean changed = (GLboolean)(f->activeTexture != unit);",
+        "    f->activeTexture = unit;",
+        "    return glExt_FilterCount(f, changed);",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindTexture(GLenum target, GLuint texture)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    int slot = glExt_FilterTexture(target);",
+        "    if (slot < 0 || f->activeTexture >= GLEXTL_FILTER_UNITS) return glExt_FilterCount(f, GL_TRUE);",
+        "    GLuint* bound = &f->textures[f->activeTexture][slot];",
+        "    GLboolean changed = (GLboolean)(*bound != texture);",
+        "    *bound = texture;",
+        "    return glExt_FilterCount(f, changed);",
+        "}",
+        "",
+        "// These bind to the target of each texture, which is not known here, so every target of the units is forgotten",
+        "GLboolean glExt_FilterBindTextureUnit(GLuint unit, GLuint texture)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    (void)texture;",
+        "    if (unit < GLEXTL_FILTER_UNITS) memset(f->textures[unit], 0xff, sizeof(f->textures[unit]));",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "GLboolean glExt_FilterBindTextures(GLuint first, GLsizei count, const GLuint* textures)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    (void)textures;",
+        "    for (GLuint unit = first; unit < GLEXTL_FILTER_UNITS && unit - first < (GLuint)count; unit++)",
+        "        memset(f->textures[unit], 0xff, sizeof(f->textures[unit]));",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "static GLboolean glExt_FilterSetEnabled(GLenum cap, GLubyte enabled)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    int slot = glExt_FilterCap(cap);",
+        "    if (slot < 0) return glExt_FilterCount(f, GL_TRUE);",
+        "    GLboolean changed = (GLboolean)(f->enables[slot] != enabled);",
+        "    f->enables[slot] = enabled;",
+        "    return glExt_FilterCount(f, changed);",
+        "}",
+        "",
+        "GLboolean glExt_FilterEnable(GLenum cap) { return glExt_FilterSetEnabled(cap, 1); }",
+        "GLboolean glExt_FilterDisable(GLenum cap) { return glExt_FilterSetEnabled(cap, 0); }",
+        "",
+        "// Only one index changes, so the state of the cap as a whole is no longer known",
+        "GLboolean glExt_FilterEnablei(GLenum target, GLuint index)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    int slot = glExt_FilterCap(target);",
+        "    (void)index;",
+        "    if (slot >= 0) f->enables[slot] = 0xff;",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "GLboolean glExt_FilterDisablei(GLenum target, GLuint index) { return glExt_FilterEnablei(target, index); }",
+        "",
+        "GLboolean glExt_FilterDeleteBuffers(GLsizei n, const GLuint* buffers)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    glExt_FilterUnbind(f->buffers, GLEXTL_FILTER_BUFFERS, n, buffers);",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "GLboolean glExt_FilterDeleteVertexArrays(GLsizei n, const GLuint* arrays)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    GLuint bound = f->vertexArray;",
+        "    glExt_FilterUnbind(&f->vertexArray, 1, n, arrays);",
+        "    if (f->vertexArray != bound) f->buffers[glExt_FilterBuffer(GL_ELEMENT_ARRAY_BUFFER)] = GLEXTL_FILTER_UNKNOWN;",
+        "    return GL_TRUE;",
+        "}",
+        "",
+        "GLboolean glExt_FilterDeleteTextures(GLsizei n, const GLuint* textures)",
+        "{",
+        "    struct GLExtFilterState* f = glExt_FilterState();",
+        "    glExt_FilterUnbind(&f->textures[0][0], GLEXTL_FILTER_UNITS * GLEXTL_FILTER_TARGETS, n, textures);",
+        "    return GL_TRUE;",
+        "}",
+    });
+    return out;
+}
 
-    out << "/* " << feature.name << " */;" << std::endl;
-    for (auto mappedPrototype : feature.mapped)
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Capture layer
+////////////////////////////////////////////////////////////////////////////////////////////
+// How a parameter is recorded by GLEXTL_CAPTURE and passed again by glExtReplay
+enum class CaptureKind
+{
+    Value,      // copied as is
+    Array,      // count elements that are copied
+    Pointer,    // client memory of unknown size, the call is not replayed
+    Buffer,     // an offset when a buffer is bound to binding, count bytes of client memory otherwise
+    Offsets,    // an array of count offsets when a buffer is bound to binding, like the indices of glMultiDrawElements
+    String,     // a string of length characters, or up to its terminator
+    Strings,    // count strings with an optional array of lengths
+    Output,     // written by the driver, replayed into scratch memory
+    Zero,       // callbacks, sync objects and other handles that mean nothing in another process
+};
+
+struct CaptureParameter
+{
+    std::string type;
+    std::string_view name;
+    CaptureKind kind = CaptureKind::Value;
+    std::string count;          // elements of Array and Output, the number of Strings or the length of a String
+    std::string element;        // the type of one element of Array and Output
+    std::string_view lengths;   // the length array of Strings
+    std::string binding;        // the buffer binding that turns a Buffer or Offsets pointer into an offset
+};
+
+// The type without const and '*', "GLfloat" for "const GLfloat *"
+std::string elementOf(std::string_view type)
+{
+    std::string element;
+    for (auto c : type) if (c != '*') element += c;
+    std::string::size_type pos;
+    while ((pos = element.find("const")) != std::string::npos) element.erase(pos, 5);
+    return std::string(trim(element));
+}
+
+// The number of components of glUniform4fv and glUniformMatrix2x3fv, 0 for everything else
+int uniformComponents(std::string_view function)
+{
+    if (function.compare(0, 2, "gl") == 0) function.remove_prefix(2);
+    if (function.compare(0, 7, "Program") == 0) function.remove_prefix(7);
+    if (function.compare(0, 7, "Uniform") != 0) return 0;
+    function.remove_prefix(7);
+
+    int components = 0;
+    if (function.compare(0, 6, "Matrix") == 0 && function.size() > 6 && function[6] >= '2' && function[6] <= '4')
+    {
+        int columns = function[6] - '0', rows = columns;
+        function.remove_prefix(7);
+        if (function.size() >= 2 && function[0] == 'x' && function[1] >= '2' && function[1] <= '4')
+        {
+            rows = function[1] - '0';
+            function.remove_prefix(2);
+        }
+        components = columns * rows;
+    }
+    else if (!function.empty() && function[0] >= '1' && function[0] <= '4')
     {
-        out << mappedPrototype.second.name << " __" << mappedPrototype.first.name << " = 0; ";
-        out << mappedPrototype.first.decl << " { if (__" << mappedPrototype.first.name << " != 0) " << (mappedPrototype.second.returnType != "void" ? "return " : "") << "(__" << mappedPrototype.first.name << ")(";
-        out << join(", ", mappedPrototype.second.params);
-        out << "); " << (mappedPrototype.second.returnType != "void" ? "return 0;" : "") << " }" << std::endl;
+        components = function[0] - '0';
+        function.remove_prefix(1);
     }
+    else
+        return 0;
 
-    out << "GLboolean __load" << feature.name << "()" << std::endl;
-    out << "{" << std::endl;
-    out << "    GLboolean r = GL_FALSE;" << std::endl;
-    for (auto j : feature.mapped) out << "    r = ((__" << j.first.name << " = (" << j.second.name << ")glExt_GetProcAddress((const GLubyte*)\"" << j.first.name << "\")) == NULL) || r;" << std::endl;
-    out << "    return r;" << std::endl;
-    out << "}" << std::endl;
-    out << "static GLboolean __isLoaded" << feature.name << " = GL_FALSE;" << std::endl << std::endl;
+    while (!function.empty() && function.back() >= 'A' && function.back() <= 'Z') function.remove_suffix(1);
+    return !function.empty() && function.back() == 'v' ? components : 0;
+}
+
+// The number of components of glVertexAttrib4Nubv and glColor3fv, 0 for everything else
+int vectorComponents(std::string_view function)
+{
+    while (!function.empty() && function.back() >= 'A' && function.back() <= 'Z') function.remove_suffix(1);
+    if (function.empty() || function.back() != 'v') return 0;
+    function.remove_suffix(1);
+
+    // The type, like ub, f or i64
+    if (function.size() > 2 && function.compare(function.size() - 2, 2, "64") == 0) function.remove_suffix(2);
+    while (!function.empty() && function.back() >= 'a' && function.back() <= 'z') function.remove_suffix(1);
+    if (!function.empty() && function.back() == 'N') function.remove_suffix(1);
+    return !function.empty() && function.back() >= '1' && function.back() <= '4' ? function.back() - '0' : 0;
+}
+
+// The glExt_ImageBytes call for the image of a glTexImage2D or glReadPixels, with the pixel store state of the capturing
+// or the replaying context, or "" when the function has no width, format and type
+std::string imageBytes(const std::vector<CaptureParameter>& params, bool pack)
+{
+    auto has = [&](std::string_view name) { return std::any_of(params.begin(), params.end(), [&](auto& p) { return p.name == name; }); };
+    if (!has("width") || !has("format") || !has("type")) return "";
+
+    int dimensions = has("depth") ? 3 : has("height") ? 2 : 1;
+    return std::string("glExt_ImageBytes(") + (pack ? "1, " : "0, ") + std::to_string(dimensions)
+            + ", width, " + (dimensions >= 2 ? "height" : "1") + ", " + (dimensions == 3 ? "depth" : "1") + ", format, type)";
+}
+
+// The buffer binding a pointer parameter is an offset into when a buffer is bound, or "" for client memory only
+std::string bufferBinding(std::string_view function, std::string_view name)
+{
+    if (name == "pixels") return "0x88EF";
+    if (name == "indices" && function.find("Elements") != std::string_view::npos) return "0x8895";
+    if (name == "indirect" && function.find("Bindless") == std::string_view::npos) return "0x8F43";
+    if (name == "pointer" && function.find("Pointer") != std::string_view::npos) return "0x8894";
+    return "";
+}
 
-    return out.str();
+// How many bytes of client memory a Buffer pointer points to when no buffer is bound, or "-1" when that is not known
+std::string bufferBytes(std::string_view function, const std::vector<CaptureParameter>& params, const CaptureParameter& p)
+{
+    auto has = [&](std::string_view name) { return std::any_of(params.begin(), params.end(), [&](auto& other) { return other.name == name; }); };
+
+    if (p.name == "pixels")
+    {
+        if (has("imageSize")) return "imageSize";
+        std::string image = imageBytes(params, false);
+        return image.empty() ? "-1" : image;
+    }
+    if (p.name == "indices" && has("count") && has("type")) return "(long long)count * glExt_IndexBytes(type)";
+    if (p.name == "indirect")
+    {
+        // The commands of glDrawArraysIndirect are four values, the ones of glDrawElementsIndirect five
+        std::string command = function.find("Elements") != std::string_view::npos ? "20" : "16";
+        std::string count = has("maxdrawcount") ? "maxdrawcount" : has("drawcount") ? "drawcount" : "";
+        if (count.empty()) return command;
+        return "(" + count + " > 0 ? (long long)(" + count + " - 1) * (stride != 0 ? stride : " + command + ") + " + command + " : 0)";
+    }
+    return "-1";
 }
 
-std::string WriteAllFeatures(const std::vector<Feature>& features)
+// How many elements a pointer parameter points to, as an expression of the other parameters, or "" when that is not known
+std::string captureCount(std::string_view function, const std::vector<CaptureParameter>& params, const CaptureParameter& p, bool output)
 {
+    auto value = [&](std::string_view name) -> const CaptureParameter*
+    {
+        for (auto& other : params)
+            if (other.name == name && other.type.find('*') == std::string::npos) return &other;
+        return nullptr;
+    };
+
+    if (!p.count.empty()) return p.count;
+
+    if (p.element == "void")
+    {
+        auto size = value("size");
+        bool chars = std::any_of(params.begin(), params.end(), [](auto& other) { return other.element == "GLchar"; });
+        if (size != nullptr && size->type.compare(0, 10, "GLsizeiptr") == 0) return "size";
+        if (output && value("bufSize") != nullptr) return "bufSize";
+        if (output) return imageBytes(params, true);
+        if (value("length") != nullptr && !chars) return "length";
+        return "";
+    }
+
+    // The viewports and scissor boxes of glViewportArrayv and glScissorIndexedv
+    if (function == "glViewportArrayv" || function == "glScissorArrayv") return "count * 4";
+    if (function == "glDepthRangeArrayv") return "count * 2";
+    if (function == "glViewportIndexedfv" || function == "glScissorIndexedv") return "4";
+
+    // A count named after the array, like numAttachments for attachments
+    if (!p.name.empty())
+    {
+        std::string num = "num" + std::string(p.name);
+        num[3] = char(std::toupper((unsigned char)num[3]));
+        if (value(num) != nullptr) return num;
+    }
+
+    // A count of its own like uniformCount or propCount, before the plain count and n
+    std::string count;
+    for (auto& other : params)
+    {
+        if (other.type != "GLsizei" || other.name.size() <= 5 || other.name.compare(other.name.size() - 5, 5, "Count") != 0) continue;
+        if (other.name != "drawCount" && other.name != "maxDrawCount") count = std::string(other.name);
+    }
+    for (auto name : { "n", "count", "drawcount" })
+        if (count.empty() && value(name) != nullptr) count = name;
+
+    int components = uniformComponents(function);
+    if (components == 0) components = vectorComponents(function);
+
+    if (!count.empty()) return components > 1 ? count + " * " + std::to_string(components) : count;
+    if (output) return value("bufSize") != nullptr ? "bufSize" : "";
+
+    size_t pointers = 0;
+    for (auto& other : params) if (other.type.find('*') != std::string::npos) pointers++;
+    if (components > 0 && pointers == 1) return std::to_string(components);
+    if (p.name == "m" && function.find("Matrix") != std::string_view::npos) return "16";
+
+    // Parameters by pname and clear values are at most four values, a few bytes more are read when there are less
+    bool clear = function.find("ClearBuffer") != std::string_view::npos || function.find("ClearNamedFramebuffer") != std::string_view::npos;
+    if ((p.name == "params" || p.name == "param" || p.name == "value" || p.name == "values") && (value("pname") != nullptr || clear)) return "4";
+    return "";
+}
+
+// Splits the parameters of a prototype and works out how each of them is captured
+std::vector<CaptureParameter> CaptureParameters(std::string_view function, std::string_view decl)
+{
+    std::vector<CaptureParameter> params;
+    std::string_view list = decl.substr(decl.find('(') + 1);
+    list = list.substr(0, list.find_last_of(')'));
+
+    while (!list.empty())
+    {
+        std::string_view p = list.substr(0, list.find(','));
+        list.remove_prefix(std::min(list.size(), p.size() + 1));
+        p = trim(p);
+        if (p.empty() || p == "void") continue;
+
+        // "GLuint baseAndCount[2]" is passed as a pointer to two elements
+        CaptureParameter c;
+        std::string_view::size_type bracket = p.find('[');
+        std::string_view declarator = trim(p.substr(0, bracket));
+        std::string_view::size_type split = declarator.find_last_of("* ") + 1;
+        c.name = declarator.substr(split);
+        c.type = std::string(trim(declarator.substr(0, split)));
+        if (bracket != std::string_view::npos)
+        {
+            c.type += " *";
+            c.count = std::string(p.substr(bracket + 1, p.find(']') - bracket - 1));
+        }
+        c.element = elementOf(c.type);
+        params.push_back(c);
+    }
+
+    for (auto& p : params)
+    {
+        size_t stars = size_t(std::count(p.type.begin(), p.type.end(), '*'));
+        bool constant = p.type.compare(0, 6, "const ") == 0;
+        bool chars = p.element == "GLchar" || p.element == "GLcharARB";
+
+        if (p.type.find("PROC") != std::string::npos || p.type == "GLsync" || p.type.compare(0, 5, "GLegl") == 0 || p.type.compare(0, 7, "struct ") == 0
+                || p.name == "userParam")
+            p.kind = CaptureKind::Zero;
+        else if (stars == 0)
+            p.kind = CaptureKind::Value;
+        else if (!constant)
+        {
+            p.kind = CaptureKind::Output;
+            p.count = captureCount(function, params, p, true);
+        }
+        else if (chars && stars == 1)
+        {
+            p.kind = CaptureKind::String;
+            std::string length = std::string(p.name) + "len";
+            for (auto& other : params)
+                if ((other.name == "length" || other.name == length) && other.type.find('*') == std::string::npos) p.count = std::string(other.name);
+            if (p.count.empty()) p.count = "-1";
+        }
+        else if (chars && stars == 2)
+        {
+            p.kind = CaptureKind::Strings;
+            p.count = captureCount(function, params, p, false);
+            for (auto& other : params)
+                if (other.name == "length" && other.type.find('*') != std::string::npos) p.lengths = other.name;
+            if (p.count.empty()) p.kind = CaptureKind::Pointer;
+        }
+        else if (stars == 1 && p.element == "void" && !bufferBinding(function, p.name).empty())
+        {
+            p.kind = CaptureKind::Buffer;
+            p.binding = bufferBinding(function, p.name);
+            p.count = bufferBytes(function, params, p);
+        }
+        else if (stars == 2 && p.element == "void")
+        {
+            // Arrays of pointers are only offsets into a bound buffer, client pointers mean nothing in another process
+            p.element = "void*";
+            p.binding = bufferBinding(function, p.name);
+            p.count = captureCount(function, params, p, false);
+            p.kind = p.count.empty() || p.binding.empty() ? CaptureKind::Pointer : CaptureKind::Offsets;
+        }
+        else
+        {
+            p.count = stars == 1 ? captureCount(function, params, p, false) : "";
+            p.kind = p.count.empty() ? CaptureKind::Pointer : CaptureKind::Array;
+        }
+    }
+
+    return params;
+}
+
+// The size of one element in the generated code, void pointers count in bytes
+std::string sizeOfElement(const CaptureParameter& p)
+{
+    return p.element == "void" ? "1" : "sizeof(" + p.element + ")";
+}
+
+// A (void) cast for every parameter that body does not use, so the stubs build clean with -Wunused-parameter. Leaving
+// the names out instead is not C before C23.
+std::string voidUnused(const std::vector<CaptureParameter>& params, std::string_view body)
+{
+    auto identifier = [](char c) { return std::isalnum((unsigned char)c) || c == '_'; };
+    auto used = [&](std::string_view name)
+    {
+        for (size_t at = body.find(name); at != std::string_view::npos; at = body.find(name, at + 1))
+            if ((at == 0 || !identifier(body[at - 1])) && (at + name.size() == body.size() || !identifier(body[at + name.size()]))) return true;
+        return false;
+    };
+
+    std::string casts;
+    for (auto& p : params)
+        if (!p.name.empty() && !used(p.name)) append(casts, "(void)", p.name, "; ");
+    return casts;
+}
+
+// Records the id and the arguments of one entry point, called by its wrapper while capturing
+void WriteCaptureFunction(std::string& out, const Prototype& prototype, size_t id)
+{
+    auto& name = prototype.name;
+    auto& decl = prototype.decl;
+    std::string_view::size_type pos = decl.find("APIENTRY ") + std::string_view("APIENTRY ").size();
+
+    auto params = CaptureParameters(name, decl);
+    std::string body = "glExt_CaptureBegin(" + std::to_string(id) + "); ";
+    for (auto& p : params)
+    {
+        switch (p.kind)
+        {
+        case CaptureKind::Value: append(body, "glExt_CaptureValue(&", p.name, ", sizeof(", p.name, ")); "); break;
+        case CaptureKind::Array: append(body, "glExt_CaptureArray(", p.name, ", (long long)(", p.count, "), ", sizeOfElement(p), "); "); break;
+        case CaptureKind::Pointer: append(body, "glExt_CapturePointer(", p.name, "); "); break;
+        case CaptureKind::Buffer: append(body, "glExt_CaptureBuffer(", p.name, ", ", p.binding, ", (long long)(", p.count, ")); "); break;
+        case CaptureKind::Offsets: append(body, "glExt_CaptureOffsets(", p.name, ", (long long)(", p.count, "), ", p.binding, "); "); break;
+        case CaptureKind::String: append(body, "glExt_CaptureString(", p.name, ", ", p.count, "); "); break;
+        case CaptureKind::Strings: append(body, "glExt_CaptureStrings(", p.name, ", ", p.count, ", ", (p.lengths.empty() ? std::string_view("0") : p.lengths), "); "); break;
+        case CaptureKind::Output: case CaptureKind::Zero: break;
+        }
+    }
+    body.append("glExt_CaptureEnd(); }\n");
+
+    // Outputs and handles are not recorded
+    writeDeclaration(out, "static void APIENTRY __glExtCapture" + std::string(name) + std::string(decl.substr(pos + name.size())));
+    append(out, " { ", voidUnused(params, body), body);
+}
+
+// One case of the glExtReplay switch: reads the arguments back in the order they were captured and makes the call
+void WriteReplayCall(std::vector<std::string>& out, const Prototype& prototype, size_t id)
+{
+    auto params = CaptureParameters(prototype.name, prototype.decl);
+    std::string field(DispatchField(prototype.name));
+
+    std::string line = "case " + std::to_string(id) + ": {";
+    for (auto& p : params)
+    {
+        switch (p.kind)
+        {
+        case CaptureKind::Value: append(line, " ", p.type, " ", p.name, "; glExt_ReplayValue(_r, &", p.name, ", sizeof(", p.name, "));"); break;
+        case CaptureKind::Array: case CaptureKind::Pointer: case CaptureKind::Buffer: case CaptureKind::Offsets: case CaptureKind::String:
+            append(line, " ", p.type, " ", p.name, " = (", p.type, ")glExt_ReplayArray(_r);"); break;
+        case CaptureKind::Strings: append(line, " ", p.type, " ", p.name, " = (", p.type, ")glExt_ReplayStrings(_r);"); break;
+        case CaptureKind::Zero: append(line, " ", p.type, " ", p.name, " = 0;"); break;
+        case CaptureKind::Output: break;
+        }
+    }
+
+    // Outputs can be sized by any of the other arguments, so they come last. They all share the same scratch memory.
+    std::string size;
+    for (auto& p : params)
+    {
+        if (p.kind != CaptureKind::Output) continue;
+        if (size.empty()) size = "0";
+        if (!p.count.empty()) append(size, " + (long long)(", p.count, ") * ", sizeOfElement(p));
+    }
+    if (!size.empty()) append(line, " void* _scratch = glExt_ReplayScratch(", size, ");");
+    for (auto& p : params)
+        if (p.kind == CaptureKind::Output) append(line, " ", p.type, " ", p.name, " = (", p.type, ")_scratch;");
+
+    append(line, " if (_r->broken || _r->skipped || GLEXTL_DISPATCH.", field, " == 0) return; GLEXTL_DISPATCH.", field, "(");
+    for (size_t i = 0; i < params.size(); i++) append(line, (i > 0 ? ", " : ""), params[i].name);
+    line.append("); return; }");
+    out.push_back(line);
+}
+
+// The declarations of the capture layer for glextl.h, only written when the generator runs with --capture
+std::vector<std::string> WriteCaptureDeclarations()
+{
+    return {
+        "// Only with GLEXTL_CAPTURE defined for the implementation: every call through the gl* functions is recorded with its",
+        "// arguments and the memory they point to when its size is known, and handed to write one record at a time. Capture",
+        "// from one thread at a time. glExtReplay plays a captured stream back on the current context, and returns the number",
+        "// of records or -1 for a broken stream. Object names, return values and mapped buffers are not captured. Pointers",
+        "// into a bound buffer are replayed as offsets, and calls with client memory of unknown size are not replayed.",
+        "typedef void (GLEXTCAPTUREWRITE)(const void* data, GLsizeiptr size, void* user);",
+        "void glExtCaptureBegin(GLEXTCAPTUREWRITE* write, void* user);",
+        "void glExtCaptureEnd(void);",
+        "long long glExtReplay(const void* data, GLsizeiptr size);",
+        "extern int __glExtCapturing;",
+        "void glExt_CaptureBegin(int id);",
+        "void glExt_CaptureEnd(void);",
+        "void glExt_CaptureValue(const void* value, GLsizeiptr size);",
+        "void glExt_CaptureArray(const void* data, long long count, GLsizeiptr size);",
+        "void glExt_CapturePointer(const void* data);",
+        "void glExt_CaptureBuffer(const void* data, GLenum binding, long long size);",
+        "void glExt_CaptureOffsets(const void* const* data, long long count, GLenum binding);",
+        "long long glExt_IndexBytes(GLenum type);",
+        "long long glExt_ImageBytes(int pack, int dimensions, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type);",
+        "void glExt_CaptureString(const GLchar* s, long long length);",
+        "void glExt_CaptureStrings(const GLchar* const* strings, long long count, const GLint* lengths);",
+        "#ifdef GLEXTL_CAPTURE",
+        "#define GLEXTL_CAPTURE_CALL(name, args) if (__glExtCapturing) __glExtCapture##name args;",
+        "#else",
+        "#define GLEXTL_CAPTURE_CALL(name, args)",
+        "#endif",
+    };
+}
+
+// The wrapper of one entry point, that calls through the dispatch table of the current context. With capture it
+// also hands its arguments to a capture function first.
+void WriteWrapper(std::string& out, const std::pair<const Prototype, TypeDefinition>& mappedPrototype, size_t id, bool capture, bool hot)
+{
+    std::string_view field = DispatchField(mappedPrototype.first.name);
+    std::string_view returnType = returnTypeOf(mappedPrototype.first.decl);
+    bool returns = returnType != "void";
+
+    // Filtered calls are dropped before they are timed or captured
+    std::string_view filter = FilterOf(mappedPrototype.first.name);
+    if (hot) out.append("GLEXTL_HOT ");
+    writeDeclaration(out, mappedPrototype.first.decl);
+    out.append(" { ");
+    if (!filter.empty())
+    {
+        append(out, "GLEXTL_FILTER_CALL(", filter, ", (");
+        join(out, ", ", mappedPrototype.second.params);
+        out.append(")) ");
+    }
+    out.append("GLEXTL_PROFILE_BEGIN ");
+    if (capture)
+    {
+        append(out, "GLEXTL_CAPTURE_CALL(", mappedPrototype.first.name, ", (");
+        join(out, ", ", mappedPrototype.second.params);
+        out.append(")) ");
+    }
+    if (returns) append(out, returnType, " r = 0; ");
+    append(out, mappedPrototype.second.name, " __proc = GLEXTL_LOAD_PROC(", mappedPrototype.second.name, ", GLEXTL_DISPATCH.", field, "); ");
+    append(out, "if (__proc != 0) ", (returns ? "r = " : ""), "__proc(");
+    join(out, ", ", mappedPrototype.second.params);
+    append(out, "); GLEXTL_PROFILE_END(", std::to_string(id), ")", (returns ? " return r;" : ""), " }\n");
+}
+
+// The wrappers and lazy stubs of one feature, the functions are looked up through the tables of WriteProcTables.
+// The wrappers of hot entry points are left out, WriteHotImplementation writes them together.
+void WriteFeatureImplementation(std::string& out, const Feature& feature, size_t first, bool capture, const std::set<std::string_view>& hot)
+{
+    append(out, "/* ", feature.name, " */;\n");
+
+    // With GLEXTL_DIRECT_DISPATCH the gl names are macros for the dispatch table entries, and there are no wrappers
+    if (!feature.mapped.empty()) out.append("#ifndef GLEXTL_DIRECT_DISPATCH\n");
+    if (capture && !feature.mapped.empty())
+    {
+        out.append("#ifdef GLEXTL_CAPTURE\n");
+        size_t id = first;
+        for (auto& mappedPrototype : feature.mapped)
+        {
+            if (hot.count(mappedPrototype.first.name) == 0) WriteCaptureFunction(out, mappedPrototype.first, id);
+            id++;
+        }
+        out.append("#endif\n");
+    }
+    size_t id = first;
+    for (auto& mappedPrototype : feature.mapped)
+    {
+        if (hot.count(mappedPrototype.first.name) == 0) WriteWrapper(out, mappedPrototype, id, capture, false);
+        id++;
+    }
+    if (!feature.mapped.empty()) out.append("#endif\n");
+
+    // With GLEXTL_LAZY every entry point can start out at a stub that looks it up on its first call, with the same
+    // fall back on its aliases as the load functions
+    if (feature.mapped.empty()) return;
+    out.append("#ifdef GLEXTL_LAZY\n");
+    id = first;
+    for (auto& mappedPrototype : feature.mapped)
+    {
+        auto& name = mappedPrototype.first.name;
+        auto& decl = mappedPrototype.first.decl;
+        std::string_view field = DispatchField(name);
+        bool returns = mappedPrototype.second.returnType != "void";
+
+        std::string_view::size_type pos = decl.find("APIENTRY ") + std::string_view("APIENTRY ").size();
+        out.append("static ");
+        writeDeclaration(out, std::string(decl.substr(0, pos)) + "__glExtLazy" + std::string(name) + std::string(decl.substr(pos + name.size())));
+        append(out, " { GLEXTL_STORE_PROC(GLEXTL_DISPATCH.", field, ", (", mappedPrototype.second.name, ")glExt_ResolveProc(", std::to_string(id++), ")); ");
+        append(out, mappedPrototype.second.name, " __proc = GLEXTL_LOAD_PROC(", mappedPrototype.second.name, ", GLEXTL_DISPATCH.", field, "); ");
+        append(out, "if (__proc != 0) ", (returns ? "return " : ""), "__proc(");
+        join(out, ", ", mappedPrototype.second.params);
+        append(out, "); ", (returns ? "return 0;" : ""), " }\n");
+    }
+    append(out, "void __lazy", feature.name, "()\n");
+    out.append("{\n");
+    for (auto& j : feature.mapped) append(out, "    GLEXTL_STORE_PROC(GLEXTL_DISPATCH.", DispatchField(j.first.name), ", &__glExtLazy", j.first.name, ");\n");
+    out.append("}\n");
+    out.append("#endif\n");
+}
+
+void WriteFullFeature(std::string& out, const Feature& feature, size_t first, bool capture, const std::set<std::string_view>& hot)
+{
+    WriteFeatureImplementation(out, feature, first, capture, hot);
+    out.append("\n");
+}
+
+// The wrappers of the entry points of a call profile, most called first, so the ones of the submission loop share
+// their pages and cache lines. GCC and clang also move them to .text.hot, away from the code that runs once.
+void WriteHotImplementation(std::string& out, const std::vector<Feature>& features, bool capture, const std::vector<std::string>& hot)
+{
+    std::map<std::string_view, std::pair<const std::pair<const Prototype, TypeDefinition>*, size_t>> entryPoints;
+    std::vector<size_t> first = FirstEntryPoints(features);
+    for (size_t i = 0; i < features.size(); i++)
+    {
+        size_t id = first[i];
+        for (auto& mappedPrototype : features[i].mapped)
+            entryPoints.insert(std::make_pair(std::string_view(mappedPrototype.first.name), std::make_pair(&mappedPrototype, id++)));
+    }
+
+    std::vector<std::pair<const std::pair<const Prototype, TypeDefinition>*, size_t>> found;
+    for (auto& name : hot)
+    {
+        auto entryPoint = entryPoints.find(name);
+        if (entryPoint != entryPoints.end()) found.push_back(entryPoint->second);
+    }
+    if (found.empty()) return;
+
+    out.append("/* Hot entry points */;\n");
+    out.append("#ifndef GLEXTL_DIRECT_DISPATCH\n");
+    out.append("#if defined(__GNUC__)\n");
+    out.append("#define GLEXTL_HOT __attribute__((hot))\n");
+    out.append("#else\n");
+    out.append("#define GLEXTL_HOT\n");
+    out.append("#endif\n");
+    if (capture)
+    {
+        out.append("#ifdef GLEXTL_CAPTURE\n");
+        for (auto& entryPoint : found) WriteCaptureFunction(out, entryPoint.first->first, entryPoint.second);
+        out.append("#endif\n");
+    }
+    for (auto& entryPoint : found) WriteWrapper(out, *entryPoint.first, entryPoint.second, capture, true);
+    out.append("#endif\n\n");
+}
+
+// The names of a call profile that are wrapped by WriteHotImplementation instead of with their feature
+std::set<std::string_view> HotNames(const std::vector<Feature>& features, const std::vector<std::string>& hot)
+{
+    std::set<std::string_view> wanted(hot.begin(), hot.end()), result;
+    for (auto& feature : features)
+        for (auto& mappedPrototype : feature.mapped)
+            if (wanted.count(mappedPrototype.first.name) != 0) result.insert(mappedPrototype.first.name);
+    return result;
+}
+
+// What the load functions need to know of a feature that is implemented in another file
+void WriteFeatureDeclaration(std::string& out, const Feature& feature)
+{
+    if (!feature.mapped.empty()) append(out, "void __lazy", feature.name, "();\n");
+}
+
+std::string WriteAllFeatures(const std::vector<Feature>& features, int jobs, bool implementations, bool capture, const std::vector<std::string>& hot)
+{
+    std::vector<std::string> written(features.size());
+    std::vector<size_t> first = FirstEntryPoints(features);
+    std::set<std::string_view> hotNames = HotNames(features, hot);
+    ParallelFor(features.size(), jobs, [&](size_t i)
+    {
+        if (implementations)
+            WriteFullFeature(written[i], features[i], first[i], capture, hotNames);
+        else
+            WriteFeatureDeclaration(written[i], features[i]);
+    });
+
+    // Glue them together in the order they came from the header, after the hot wrappers
     std::string result;
-    for (auto feature : features) result += WriteFullFeature(feature);
+    if (implementations) WriteHotImplementation(result, features, capture, hot);
+
+    size_t size = result.size();
+    for (auto& w : written) size += w.size();
+
+    result.reserve(size);
+    for (auto& w : written) result += w;
     return result;
 }
 
-std::vector<std::string> WriteFeaturesForLoadAll(const std::vector<Feature>& features)
+std::vector<std::string> WriteFeaturesForLoadLazy(const std::vector<Feature>& features)
 {
     std::vector<std::string> out;
-    for (auto feature : features)
-        out.push_back(std::string("__isLoaded") + feature.name + " = __load" + feature.name + "();");
+    for (auto& feature : features)
+        if (!feature.mapped.empty()) out.push_back("__lazy" + std::string(feature.name) + "();");
     return out;
 }
 
-std::vector<std::string> WriteFeaturesFor_LoadOne(const std::vector<Feature>& features)
+// The feature ids and the loaded bitset, for the declarations in glextl.h
+std::vector<std::string> WriteFeatureIds(const std::vector<Feature>& features)
 {
     std::vector<std::string> out;
-    for (auto feature : features)
-        out.push_back(std::string("if(strcmp(name,\"") + feature.name + "\") == 0) return __isLoaded" + feature.name + " = __load" + feature.name + "();");
+
+    std::string ids = "enum GLExtFeature\n{\n";
+    for (auto& feature : features) append(ids, "    GLEXTL_", feature.name, ",\n");
+    ids.append("    GLEXTL_FEATURE_COUNT\n};");
+    out.push_back(ids);
+
+    out.push_back("#define GLEXTL_FEATURE_WORDS (GLEXTL_FEATURE_COUNT / 32 + 1)");
     return out;
 }
 
-std::vector<std::string> WriteFeaturesFor_IsLoaded(const std::vector<Feature>& features)
+// The dispatch table field of a gl function, glDrawArrays is stored as DrawArrays
+std::string_view DispatchField(std::string_view name)
+{
+    if (name.compare(0, 2, "gl") == 0) name.remove_prefix(2);
+    return name;
+}
+
+// The entry points in dispatch table order: the ones of a call profile first, most called first, then the draw,
+// bind and uniform calls of the submission loop, so they share a few cache lines, and everything else after them
+// in header order
+std::vector<const std::pair<const Prototype, TypeDefinition>*> DispatchOrder(const std::vector<Feature>& features, const std::vector<std::string>& profiled)
+{
+    static const std::string_view hot[] = { "glDrawArrays", "glDrawElements", "glDrawRangeElements", "glMultiDraw", "glBind", "glUseProgram", "glUniform", "glProgramUniform" };
+    std::map<std::string_view, size_t> calls;
+    for (auto& name : profiled) calls.insert(std::make_pair(std::string_view(name), calls.size()));
+
+    auto rank = [&](std::string_view name)
+    {
+        auto found = calls.find(name);
+        if (found != calls.end()) return found->second;
+
+        size_t r = 0;
+        while (r < std::size(hot) && name.compare(0, hot[r].size(), hot[r]) != 0) r++;
+        return calls.size() + r;
+    };
+
+    std::vector<const std::pair<const Prototype, TypeDefinition>*> order;
+    std::set<std::string_view> seen;
+    for (auto& feature : features)
+        for (auto& mappedPrototype : feature.mapped)
+            if (seen.insert(mappedPrototype.first.name).second) order.push_back(&mappedPrototype);
+
+    std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) { return rank(a->first.name) < rank(b->first.name); });
+    return order;
+}
+
+// The dispatch table with all function pointers and the context that holds it, for the declarations in glextl.h.
+// Every thread has its own current context, the gl functions and loaders always work on that one.
+std::string WriteDispatchTable(const std::vector<Feature>& features, const std::vector<std::string>& hot)
+{
+    auto order = DispatchOrder(features, hot);
+
+    std::string out = "struct GLExtDispatch\n{\n";
+    for (auto entry : order) append(out, "    ", entry->second.name, " ", DispatchField(entry->first.name), ";\n");
+    if (order.empty()) out.append("    int unused;\n");
+    out.append("};\n\n");
+
+    out.append(WriteFilterState());
+    out.append("struct GLExtContext\n{\n");
+    out.append("    struct GLExtDispatch dispatch;\n");
+    out.append("    GLuint loaded[GLEXTL_FEATURE_WORDS];\n");
+    out.append("    PFNGLGETPROC* proc;\n");
+    out.append("    GLuint supported[GLEXTL_FEATURE_WORDS];\n");
+    out.append("    GLboolean extensionsRead;\n");
+    out.append("    char* otherExtensions;          // the advertised names without a feature in the loader, each ended by a 0\n");
+    out.append("    GLuint otherLength;\n");
+    out.append("    struct GLExtFilterState filter;\n");
+    out.append("};\n\n");
+
+    out.append("#if defined(_MSC_VER)\n");
+    out.append("#define GLEXTL_THREAD_LOCAL __declspec(thread)\n");
+    out.append("#elif defined(__GNUC__)\n");
+    out.append("#define GLEXTL_THREAD_LOCAL __thread\n");
+    out.append("#elif defined(__cplusplus)\n");
+    out.append("#define GLEXTL_THREAD_LOCAL thread_local\n");
+    out.append("#else\n");
+    out.append("#define GLEXTL_THREAD_LOCAL _Thread_local\n");
+    out.append("#endif\n");
+    out.append("extern GLEXTL_THREAD_LOCAL struct GLExtContext* __glExtCurrent;\n");
+    out.append("#define GLEXTL_DISPATCH (__glExtCurrent->dispatch)\n");
+
+    // A lazy stub patches its entry on the first call, which can be while other threads call through the same context
+    out.append("#if defined(GLEXTL_LAZY) && defined(__GNUC__)\n");
+    out.append("#define GLEXTL_LOAD_PROC(type, entry) __atomic_load_n(&(entry), __ATOMIC_ACQUIRE)\n");
+    out.append("#define GLEXTL_STORE_PROC(entry, proc) __atomic_store_n(&(entry), (proc), __ATOMIC_RELEASE)\n");
+    out.append("#elif defined(GLEXTL_LAZY) && defined(_MSC_VER)\n");
+    out.append("#include <intrin.h>\n");
+    out.append("#define GLEXTL_LOAD_PROC(type, entry) ((type)_InterlockedCompareExchangePointer((void* volatile*)&(entry), 0, 0))\n");
+    out.append("#define GLEXTL_STORE_PROC(entry, proc) _InterlockedExchangePointer((void* volatile*)&(entry), (void*)(proc))\n");
+    out.append("#else\n");
+    out.append("#define GLEXTL_LOAD_PROC(type, entry) (entry)\n");
+    out.append("#define GLEXTL_STORE_PROC(entry, proc) ((entry) = (proc))\n");
+    out.append("#endif");
+    return out;
+}
+
+// The macros that call the dispatch table directly, for the declarations in glextl.h
+std::string WriteDirectDispatch(const std::vector<Feature>& features, const std::vector<std::string>& hot)
+{
+    std::string out = "#ifdef GLEXTL_DIRECT_DISPATCH\n";
+    for (auto entry : DispatchOrder(features, hot))
+        append(out, "#define ", entry->first.name, " GLEXTL_DISPATCH.", DispatchField(entry->first.name), "\n");
+    out.append("#endif // GLEXTL_DIRECT_DISPATCH");
+    return out;
+}
+
+// Writes "declaration = { values };" with a few values on every line
+std::string WriteTable(const std::string& declaration, const std::vector<std::string>& values, size_t perLine)
+{
+    std::string out = declaration + " =\n{";
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        out.append(i % perLine == 0 ? "\n    " : " ");
+        append(out, values[i], ",");
+    }
+    out.append("\n};");
+    return out;
+}
+
+// The type of a table of offsets and indices up to max: unsigned short keeps the tables of the registry small, and
+// unsigned int takes over when a larger registry or more aliases no longer fit in 16 bits
+std::string IndexType(size_t max)
+{
+    return max > 0xffff ? "unsigned int" : "unsigned short";
+}
+
+// Writes "name\0" strings into one packed character array, one per line, and returns the offset of every name.
+// Names that appear more than once are stored once.
+std::string WriteNameBlob(const std::string& declaration, const std::vector<std::string_view>& names, std::vector<size_t>& offsets)
+{
+    std::map<std::string_view, size_t> stored;
+    std::string out = declaration + " =";
+    size_t size = 0;
+    offsets.clear();
+    for (auto name : names)
+    {
+        auto found = stored.insert(std::make_pair(name, size));
+        if (found.second)
+        {
+            append(out, "\n    \"", name, "\\0\"");
+            size += name.size() + 1;
+        }
+        offsets.push_back(found.first->second);
+    }
+    if (size == 0) out.append(" \"\"");
+    out.append(";");
+    return out;
+}
+
+// The same hash is written into the loader as glExt_HashName, they have to stay in sync
+unsigned int FeatureNameHash(std::string_view name, unsigned int seed)
+{
+    unsigned int hash = seed == 0 ? 0x01000193u : seed;
+    for (auto c : name) hash = (hash * 0x01000193u) ^ (unsigned char)c;
+    return hash & 0xffffffffu;
+}
+
+// Builds a minimal perfect hash over the feature names with the hash and displace method: names are put in buckets
+// by their plain hash, and every bucket gets the seed that lands all of its names in free slots. Buckets with a
+// single name store its slot directly as -(slot + 1). When a name appears twice, the first one is used.
+void BuildFeatureNameHash(const std::vector<Feature>& features, std::vector<int>& displacements, std::vector<int>& slots)
+{
+    std::vector<size_t> unique;
+    std::set<std::string_view> seen;
+    for (size_t i = 0; i < features.size(); i++)
+        if (seen.insert(features[i].name).second) unique.push_back(i);
+
+    unsigned int size = (unsigned int)unique.size();
+    displacements.assign(size, 0);
+    slots.assign(size, -1);
+
+    std::vector<std::vector<size_t>> buckets(size);
+    for (auto i : unique) buckets[FeatureNameHash(features[i].name, 0) % size].push_back(i);
+
+    std::vector<unsigned int> order(size);
+    for (unsigned int b = 0; b < size; b++) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<bool> taken(size, false);
+    size_t next = 0;
+    for (auto b : order)
+    {
+        auto& bucket = buckets[b];
+        if (bucket.size() > 1)
+        {
+            std::vector<unsigned int> placed;
+            for (unsigned int seed = 1; placed.size() < bucket.size(); seed++)
+            {
+                placed.clear();
+                for (auto i : bucket)
+                {
+                    unsigned int slot = FeatureNameHash(features[i].name, seed) % size;
+                    if (taken[slot] || std::find(placed.begin(), placed.end(), slot) != placed.end()) break;
+                    placed.push_back(slot);
+                }
+                displacements[b] = int(seed);
+            }
+            for (size_t j = 0; j < bucket.size(); j++)
+            {
+                taken[placed[j]] = true;
+                slots[placed[j]] = int(bucket[j]);
+            }
+        }
+        else if (bucket.size() == 1)
+        {
+            while (taken[next]) next++;
+            taken[next] = true;
+            slots[next] = int(bucket[0]);
+            displacements[b] = -int(next) - 1;
+        }
+    }
+}
+
+// Feature lookup by name for glExtLoadOne and glExtIsLoaded: one hash, one table lookup and one strcmp
+std::vector<std::string> WriteFeatureLookup(const std::vector<Feature>& features)
 {
     std::vector<std::string> out;
-    for (auto feature : features)
-        out.push_back(std::string("if(strcmp(name,\"") + feature.name + "\") == 0) return __isLoaded" + feature.name + ";");
+    if (features.empty())
+    {
+        out.push_back("static int glExt_FeatureIndex(const char* name) { (void)name; return -1; }");
+        return out;
+    }
+
+    std::vector<int> displacements, slots;
+    BuildFeatureNameHash(features, displacements, slots);
+
+    std::vector<std::string_view> names;
+    std::vector<size_t> offsets;
+    std::vector<std::string> values;
+    for (auto& feature : features) names.push_back(feature.name);
+
+    out.push_back(WriteNameBlob("static const char __glExtFeatureNames[]", names, offsets));
+    for (auto o : offsets) values.push_back(std::to_string(o));
+    size_t largest = offsets.empty() ? 0 : *std::max_element(offsets.begin(), offsets.end());
+    out.push_back(WriteTable("static const " + IndexType(largest) + " __glExtFeatureNameOffsets[" + std::to_string(offsets.size()) + "]", values, 16));
+    values.clear();
+
+    for (auto d : displacements) values.push_back(std::to_string(d));
+    out.push_back(WriteTable("static const int __glExtFeatureHash[" + std::to_string(displacements.size()) + "]", values, 16));
+    values.clear();
+    for (auto i : slots) values.push_back(std::to_string(i));
+    out.push_back(WriteTable("static const int __glExtFeatureSlots[" + std::to_string(slots.size()) + "]", values, 16));
+
+    std::string size = std::to_string(slots.size());
+    out.push_back("");
+    out.push_back("static unsigned int glExt_HashName(const char* name, unsigned int seed)");
+    out.push_back("{");
+    out.push_back("    unsigned int hash = seed == 0 ? 0x01000193u : seed;");
+    out.push_back("    for (; *name != 0; ++name) hash = (hash * 0x01000193u) ^ (unsigned char)*name;");
+    out.push_back("    return hash & 0xffffffffu;");
+    out.push_back("}");
+    out.push_back("");
+    out.push_back("static int glExt_FeatureIndex(const char* name)");
+    out.push_back("{");
+    out.push_back("    if (name == 0) return -1;");
+    out.push_back("    int d = __glExtFeatureHash[glExt_HashName(name, 0) % " + size + "u];");
+    out.push_back("    int i = __glExtFeatureSlots[d < 0 ? -d - 1 : glExt_HashName(name, (unsigned int)d) % " + size + "u];");
+    out.push_back("    return strcmp(__glExtFeatureNames + __glExtFeatureNameOffsets[i], name) == 0 ? i : -1;");
+    out.push_back("}");
     return out;
 }
 
-std::string WriteFeatures(const std::vector<Feature>& features)
+// The names of all entry points in one packed string, with for every feature the range of (name, dispatch table offset)
+// pairs to look up. This keeps the loader a single loop over constant data, without a string literal and relocation for
+// every entry point. Every entry point also has the range of its alias names to try when it is missing.
+std::vector<std::string> WriteProcTables(const std::vector<Feature>& features, const Aliases& aliases)
+{
+    std::vector<std::string> out;
+    std::vector<std::string_view> names;
+    std::vector<size_t> offsets;
+    std::vector<std::string> values, firsts, versions, aliasNames;
+
+    for (auto& feature : features)
+    {
+        firsts.push_back(std::to_string(names.size()));
+        for (auto& mappedPrototype : feature.mapped) names.push_back(mappedPrototype.first.name);
+
+        int major, minor;
+        versions.push_back(ParseVersionFeature(feature.name, major, minor) ? std::to_string(major * 100 + minor) : "0");
+    }
+    firsts.push_back(std::to_string(names.size()));
+
+    // The alias names go after the entry points in the same string
+    size_t count = names.size();
+    for (auto& feature : features)
+    {
+        for (auto& mappedPrototype : feature.mapped)
+        {
+            auto found = aliases.find(mappedPrototype.first.name);
+            if (found != aliases.end()) names.insert(names.end(), found->second.begin(), found->second.end());
+        }
+    }
+
+    out.push_back(WriteNameBlob("static const char __glExtProcNames[]", names, offsets));
+
+    size_t i = 0;
+    for (auto& feature : features)
+    {
+        for (auto& mappedPrototype : feature.mapped)
+        {
+            std::string alias = std::to_string(aliasNames.size());
+            values.push_back("{ " + std::to_string(offsets[i++]) + ", offsetof(struct GLExtDispatch, " + std::string(DispatchField(mappedPrototype.first.name)) + "), " + alias + " }");
+
+            auto found = aliases.find(mappedPrototype.first.name);
+            if (found == aliases.end()) continue;
+            for (size_t a = 0; a < found->second.size(); a++) aliasNames.push_back(std::to_string(offsets[count++]));
+        }
+    }
+    values.push_back("{ 0, 0, " + std::to_string(aliasNames.size()) + " }");
+    if (aliasNames.empty()) aliasNames.push_back("0");
+
+    // The dispatch table only holds function pointers, so its offsets stay below 8 bytes per entry point
+    out.push_back("struct GLExtProc { unsigned int name; " + IndexType(count * 8) + " offset; " + IndexType(aliasNames.size()) + " alias; };");
+    out.push_back(WriteTable("static const struct GLExtProc __glExtProcs[" + std::to_string(values.size()) + "]", values, 1));
+    out.push_back(WriteTable("static const unsigned int __glExtAliases[" + std::to_string(aliasNames.size()) + "]", aliasNames, 16));
+    out.push_back(WriteTable("static const " + IndexType(count) + " __glExtFeatureProcs[" + std::to_string(firsts.size()) + "]", firsts, 16));
+
+    // The version of the GL_VERSION_x_y features as x * 100 + y, and 0 for extensions
+    if (versions.empty()) versions.push_back("0");
+    out.push_back(WriteTable("static const unsigned short __glExtFeatureVersions[" + std::to_string(versions.size()) + "]", versions, 16));
+
+    // The load functions and the lazy stubs both look an entry point up by its index, falling back on its aliases
+    out.push_back("");
+    out.push_back("void* glExt_ResolveProc(int i)");
+    out.push_back("{");
+    out.push_back("    void* proc = glExt_GetProcAddress((const GLubyte*)(__glExtProcNames + __glExtProcs[i].name));");
+    out.push_back("    for (int a = __glExtProcs[i].alias; proc == 0 && a < __glExtProcs[i + 1].alias; a++)");
+    out.push_back("        proc = glExt_GetProcAddress((const GLubyte*)(__glExtProcNames + __glExtAliases[a]));");
+    out.push_back("    return proc;");
+    out.push_back("}");
+    out.push_back("");
+    out.push_back("static GLboolean glExt_LoadFeature(int id)");
+    out.push_back("{");
+    out.push_back("    GLboolean r = GL_TRUE;");
+    out.push_back("    for (int i = __glExtFeatureProcs[id]; i < __glExtFeatureProcs[id + 1]; i++)");
+    out.push_back("    {");
+    out.push_back("        void* proc = glExt_ResolveProc(i);");
+    out.push_back("        memcpy((char*)&GLEXTL_DISPATCH + __glExtProcs[i].offset, &proc, sizeof(proc));");
+    out.push_back("        if (proc == 0) r = GL_FALSE;");
+    out.push_back("    }");
+    out.push_back("    return r;");
+    out.push_back("}");
+    return out;
+}
+
+// The counters behind GLEXTL_PROFILE, one for every entry point in __glExtProcs, with the functions to read them
+std::vector<std::string> WriteProfiler(const std::vector<Feature>& features)
+{
+    size_t count = 0;
+    for (auto& feature : features) count += feature.mapped.size();
+    std::string size = std::to_string(std::max(count, size_t(1)));
+
+    return {
+        "#ifdef _WIN32",
+        "#include <windows.h>",
+        "unsigned long long glExt_ProfileNow(void)",
+        "{",
+        "    static LARGE_INTEGER frequency;",
+        "    LARGE_INTEGER now;",
+        "    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);",
+        "    QueryPerformanceCounter(&now);",
+        "    return (unsigned long long)(now.QuadPart / frequency.QuadPart) * 1000000000ull + (unsigned long long)(now.QuadPart % frequency.QuadPart) * 1000000000ull / (unsigned long long)frequency.QuadPart;",
+        "}",
+        "#else",
+        "#include <time.h>",
+        "unsigned long long glExt_ProfileNow(void)",
+        "{",
+        "    struct timespec now;",
+        "    clock_gettime(CLOCK_MONOTONIC, &now);",
+        "    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;",
+        "}",
+        "#endif",
+        "",
+        "// Counted without locking, calls made at the same moment from several threads can get lost",
+        "static struct { unsigned long long calls; unsigned long long nanoseconds; } __glExtProfile[" + size + "];",
+        "",
+        "void glExt_ProfileAdd(int id, unsigned long long start)",
+        "{",
+        "    __glExtProfile[id].nanoseconds += glExt_ProfileNow() - start;",
+        "    __glExtProfile[id].calls++;",
+        "}",
+        "",
+        "void glExtProfileReset(void)",
+        "{",
+        "    memset(__glExtProfile, 0, sizeof(__glExtProfile));",
+        "}",
+        "",
+        "static int glExt_ProfileCompare(const void* a, const void* b)",
+        "{",
+        "    const struct GLExtProfileEntry* x = (const struct GLExtProfileEntry*)a;",
+        "    const struct GLExtProfileEntry* y = (const struct GLExtProfileEntry*)b;",
+        "    if (x->nanoseconds != y->nanoseconds) return x->nanoseconds > y->nanoseconds ? -1 : 1;",
+        "    if (x->calls != y->calls) return x->calls > y->calls ? -1 : 1;",
+        "    return strcmp(x->name, y->name);",
+        "}",
+        "",
+        "// The entries live on the heap, one per entry point is too much for the stack of a thread",
+        "int glExtProfileSnapshot(struct GLExtProfileEntry* entries, int count)",
+        "{",
+        "    struct GLExtProfileEntry* all = (struct GLExtProfileEntry*)malloc(sizeof(struct GLExtProfileEntry) * " + size + ");",
+        "    if (all == 0) return 0;",
+        "    int called = 0;",
+        "    for (int i = 0; i < " + std::to_string(count) + "; i++)",
+        "    {",
+        "        if (__glExtProfile[i].calls == 0) continue;",
+        "        all[called].name = __glExtProcNames + __glExtProcs[i].name;",
+        "        all[called].calls = __glExtProfile[i].calls;",
+        "        all[called].nanoseconds = __glExtProfile[i].nanoseconds;",
+        "        called++;",
+        "    }",
+        "    qsort(all, (size_t)called, sizeof(all[0]), glExt_ProfileCompare);",
+        "    if (entries != 0) memcpy(entries, all, sizeof(all[0]) * (size_t)(count < called ? count : called));",
+        "    free(all);",
+        "    return called;",
+        "}",
+        "",
+        "// Appends to the buffer as far as it fits, and keeps counting the length like snprintf",
+        "static void glExt_ReportAppend(char* buffer, int size, int* length, const char* text)",
+        "{",
+        "    int n = (int)strlen(text);",
+        "    if (buffer != 0 && *length < size - 1)",
+        "    {",
+        "        int fits = n < size - 1 - *length ? n : size - 1 - *length;",
+        "        memcpy(buffer + *length, text, (size_t)fits);",
+        "        buffer[*length + fits] = 0;",
+        "    }",
+        "    *length += n;",
+        "}",
+        "",
+        "int glExtProfileReport(char* buffer, int size, GLboolean json)",
+        "{",
+        "    struct GLExtProfileEntry* entries = (struct GLExtProfileEntry*)malloc(sizeof(struct GLExtProfileEntry) * " + size + ");",
+        "    int count = entries != 0 ? glExtProfileSnapshot(entries, " + size + ") : 0;",
+        "    int length = 0;",
+        "    char line[256];",
+        "",
+        "    if (buffer != 0 && size > 0) buffer[0] = 0;",
+        "    if (json) glExt_ReportAppend(buffer, size, &length, \"[\\n\");",
+        "    else",
+        "    {",
+        "        snprintf(line, sizeof(line), \"%-48s %12s %14s %10s\\n\", \"entry point\", \"calls\", \"total ms\", \"ns/call\");",
+        "        glExt_ReportAppend(buffer, size, &length, line);",
+        "    }",
+        "    for (int i = 0; i < count; i++)",
+        "    {",
+        "        if (json) snprintf(line, sizeof(line), \"  { \\\"name\\\": \\\"%s\\\", \\\"calls\\\": %llu, \\\"nanoseconds\\\": %llu }%s\\n\", entries[i].name, entries[i].calls, entries[i].nanoseconds, i + 1 < count ? \",\" : \"\");",
+        "        else snprintf(line, sizeof(line), \"%-48s %12llu %14.3f %10llu\\n\", entries[i].name, entries[i].calls, (double)entries[i].nanoseconds / 1000000.0, entries[i].nanoseconds / entries[i].calls);",
+        "        glExt_ReportAppend(buffer, size, &length, line);",
+        "    }",
+        "    if (json) glExt_ReportAppend(buffer, size, &length, \"]\\n\");",
+        "    free(entries);",
+        "    return length;",
+        "}",
+    };
+}
+
+// The stream behind GLEXTL_CAPTURE and glExtReplay. It starts with "GLXC", the version, the number of entry points, the
+// size of this header and the names of the entry points, and goes on with one record per call: its size, the id of the
+// entry point and the arguments. Arrays and records start at multiples of 8 bytes. The ids are the index in
+// __glExtProcs, replay finds its own entry points by name so a stream plays back with a loader of other features.
+std::vector<std::string> WriteCapture(const std::vector<Feature>& features)
+{
+    size_t count = 0;
+    std::vector<std::string> calls;
+    for (auto& feature : features)
+        for (auto& mappedPrototype : feature.mapped) WriteReplayCall(calls, mappedPrototype.first, count++);
+
+    std::vector<std::string> out = {
+        "int __glExtCapturing = 0;",
+        "static GLEXTCAPTUREWRITE* __glExtCaptureWrite = 0;",
+        "static void* __glExtCaptureUser = 0;",
+        "static PFNGLEXTGETINTEGERVPROC __glExtCaptureGetIntegerv = 0;",
+        "static PFNGLEXTGETINTEGERVPROC __glExtReplayGetIntegerv = 0;",
+        "static unsigned char* __glExtRecord = 0;",
+        "static size_t __glExtRecordSize = 0;",
+        "static size_t __glExtRecordCapacity = 0;",
+        "static int __glExtRecordBroken = 0;",
+        "",
+        "static void glExt_RecordAppend(const void* data, size_t size)",
+        "{",
+        "    if (__glExtRecordSize + size > __glExtRecordCapacity)",
+        "    {",
+        "        size_t capacity = __glExtRecordCapacity != 0 ? __glExtRecordCapacity : 4096;",
+        "        while (capacity < __glExtRecordSize + size) capacity *= 2;",
+        "        unsigned char* record = (unsigned char*)realloc(__glExtRecord, capacity);",
+        "        if (record == 0) { __glExtRecordBroken = 1; return; }",
+        "        __glExtRecord = record;",
+        "        __glExtRecordCapacity = capacity;",
+        "    }",
+        "    if (size != 0) memcpy(__glExtRecord + __glExtRecordSize, data, size);",
+        "    __glExtRecordSize += size;",
+        "}",
+        "",
+        "static void glExt_RecordAlign(void)",
+        "{",
+        "    static const unsigned char zeros[8] = { 0 };",
+        "    glExt_RecordAppend(zeros, (8 - (__glExtRecordSize & 7)) & 7);",
+        "}",
+        "",
+        "void glExt_CaptureBegin(int id)",
+        "{",
+        "    unsigned int header[2] = { 0, (unsigned int)id };",
+        "    __glExtRecordSize = 0;",
+        "    __glExtRecordBroken = 0;",
+        "    glExt_RecordAppend(header, sizeof(header));",
+        "}",
+        "",
+        "void glExt_CaptureEnd(void)",
+        "{",
+        "    glExt_RecordAlign();",
+        "    if (__glExtRecordBroken || __glExtCaptureWrite == 0 || __glExtRecordSize > 0xffffffffu) return;",
+        "    unsigned int size = (unsigned int)__glExtRecordSize;",
+        "    memcpy(__glExtRecord, &size, sizeof(size));",
+        "    __glExtCaptureWrite(__glExtRecord, (GLsizeiptr)size, __glExtCaptureUser);",
+        "}",
+        "",
+        "void glExt_CaptureValue(const void* value, GLsizeiptr size)",
+        "{",
+        "    glExt_RecordAppend(value, (size_t)size);",
+        "}",
+        "",
+        "// Pointers are their size in bytes and the bytes, ~0 for a null pointer, ~1 and an offset into a bound buffer, or ~2",
+        "// for client memory of unknown size. The address of client memory is never recorded.",
+        "void glExt_CapturePointer(const void* data)",
+        "{",
+        "    unsigned long long marker = data == 0 ? ~0ull : ~2ull;",
+        "    glExt_RecordAlign();",
+        "    glExt_RecordAppend(&marker, sizeof(marker));",
+        "}",
+        "",
+        "void glExt_CaptureArray(const void* data, long long count, GLsizeiptr size)",
+        "{",
+        "    if (data != 0 && count < 0) { glExt_CapturePointer(data); return; }",
+        "    unsigned long long bytes = data == 0 ? ~0ull : count > 0 ? (unsigned long long)count * (unsigned long long)size : 0;",
+        "    glExt_RecordAlign();",
+        "    glExt_RecordAppend(&bytes, sizeof(bytes));",
+        "    if (data != 0) glExt_RecordAppend(data, (size_t)bytes);",
+        "}",
+        "",
+        "static GLboolean glExt_CaptureBound(GLenum binding)",
+        "{",
+        "    GLint bound = 0;",
+        "    if (binding != 0 && __glExtCaptureGetIntegerv != 0) __glExtCaptureGetIntegerv(binding, &bound);",
+        "    return bound != 0;",
+        "}",
+        "",
+        "// With a buffer bound to binding the pointer is an offset into that buffer, otherwise it is size bytes of client memory",
+        "void glExt_CaptureBuffer(const void* data, GLenum binding, long long size)",
+        "{",
+        "    unsigned long long marker = ~1ull, offset = (unsigned long long)(size_t)data;",
+        "    if (!glExt_CaptureBound(binding)) { glExt_CaptureArray(data, size, 1); return; }",
+        "    glExt_RecordAlign();",
+        "    glExt_RecordAppend(&marker, sizeof(marker));",
+        "    glExt_RecordAppend(&offset, sizeof(offset));",
+        "}",
+        "",
+        "// An array of offsets into the buffer bound to binding, which are kept as pointers of this process",
+        "void glExt_CaptureOffsets(const void* const* data, long long count, GLenum binding)",
+        "{",
+        "    if (data != 0 && !glExt_CaptureBound(binding)) glExt_CapturePointer(data);",
+        "    else glExt_CaptureArray(data, count, sizeof(void*));",
+        "}",
+        "",
+        "long long glExt_IndexBytes(GLenum type)",
+        "{",
+        "    return type == 0x1401 ? 1 : type == 0x1403 ? 2 : 4;",
+        "}",
+        "",
+        "// The bytes of client memory an image of format and type is read from, or written to with pack, following the pixel",
+        "// store state of the capturing or the replaying context. -1 when the format or the type is not known.",
+        "long long glExt_ImageBytes(int pack, int dimensions, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type)",
+        "{",
+        "    static const GLenum unpackNames[6] = { 0x0CF2, 0x0CF3, 0x0CF4, 0x0CF5, 0x806E, 0x806D };",
+        "    static const GLenum packNames[6] = { 0x0D02, 0x0D03, 0x0D04, 0x0D05, 0x806C, 0x806B };",
+        "    PFNGLEXTGETINTEGERVPROC getIntegerv = pack ? __glExtReplayGetIntegerv : __glExtCaptureGetIntegerv;",
+        "    long long components = 0, size = 0;",
+        "    switch (format)",
+        "    {",
+        "    case 0x1900: case 0x1901: case 0x1902: case 0x1903: case 0x1904: case 0x1905: case 0x1906: case 0x1909:",
+        "    case 0x8D94: case 0x8D95: case 0x8D96: case 0x8D97: components = 1; break;",
+        "    case 0x190A: case 0x8227: case 0x8228: case 0x84F9: components = 2; break;",
+        "    case 0x1907: case 0x80E0: case 0x8D98: case 0x8D9A: components = 3; break;",
+        "    case 0x1908: case 0x80E1: case 0x8D99: case 0x8D9B: components = 4; break;",
+        "    default: return -1;",
+        "    }",
+        "    switch (type)",
+        "    {",
+        "    case 0x1400: case 0x1401: size = 1; break;",
+        "    case 0x1402: case 0x1403: case 0x140B: size = 2; break;",
+        "    case 0x1404: case 0x1405: case 0x1406: size = 4; break;",
+        "    // Packed types hold a whole pixel",
+        "    case 0x8032: case 0x8362: components = 1; size = 1; break;",
+        "    case 0x8033: case 0x8034: case 0x8363: case 0x8364: case 0x8365: case 0x8366: components = 1; size = 2; break;",
+        "    case 0x8035: case 0x8036: case 0x8367: case 0x8368: case 0x84FA: case 0x8C3B: case 0x8C3E: components = 1; size = 4; break;",
+        "    case 0x8DAD: components = 1; size = 8; break;",
+        "    default: return -1;",
+        "    }",
+        "    if (width <= 0 || height <= 0 || depth <= 0) return 0;",
+        "",
+        "    // The row length, skipped rows and pixels, alignment, image height and skipped images",
+        "    GLint store[6] = { 0, 0, 0, 4, 0, 0 };",
+        "    for (int i = 0; getIntegerv != 0 && i < 6; i++) getIntegerv(pack ? packNames[i] : unpackNames[i], &store[i]);",
+        "    if (store[3] <= 0) store[3] = 4;",
+        "",
+        "    long long pixel = components * size;",
+        "    long long row = pixel * (store[0] > 0 ? store[0] : width);",
+        "    if (size < store[3]) row = (row + store[3] - 1) / store[3] * store[3];",
+        "    long long image = row * (dimensions == 3 && store[4] > 0 ? store[4] : height);",
+        "    long long skip = (dimensions == 3 ? store[5] * image : 0) + (dimensions >= 2 ? store[1] * row : 0) + store[2] * pixel;",
+        "    return skip + (depth - 1) * image + (height - 1) * row + width * pixel;",
+        "}",
+        "",
+        "// Strings keep their terminator, or get one when they are given by length",
+        "void glExt_CaptureString(const GLchar* s, long long length)",
+        "{",
+        "    if (s == 0) { glExt_CaptureArray(0, 0, 1); return; }",
+        "    if (length < 0) length = (long long)strlen(s);",
+        "    unsigned long long bytes = (unsigned long long)length + 1;",
+        "    glExt_RecordAlign();",
+        "    glExt_RecordAppend(&bytes, sizeof(bytes));",
+        "    glExt_RecordAppend(s, (size_t)length);",
+        "    glExt_RecordAppend(\"\", 1);",
+        "}",
+        "",
+        "void glExt_CaptureStrings(const GLchar* const* strings, long long count, const GLint* lengths)",
+        "{",
+        "    unsigned long long n = strings == 0 ? ~0ull : count > 0 ? (unsigned long long)count : 0;",
+        "    glExt_RecordAlign();",
+        "    glExt_RecordAppend(&n, sizeof(n));",
+        "    for (long long i = 0; strings != 0 && i < count; i++) glExt_CaptureString(strings[i], lengths != 0 ? lengths[i] : -1);",
+        "}",
+        "",
+        "// The buffer bindings and pixel store state are read from the context that captures or replays",
+        "static PFNGLEXTGETINTEGERVPROC glExt_CaptureGetIntegerv(void)",
+        "{",
+        "    PFNGLEXTGETINTEGERVPROC getIntegerv = (PFNGLEXTGETINTEGERVPROC)glExt_GetProcAddress((const GLubyte*)\"glGetIntegerv\");",
+        "    #ifndef __glcorearb_h_",
+        "    if (getIntegerv == 0) getIntegerv = glGetIntegerv;",
+        "    #endif",
+        "    return getIntegerv;",
+        "}",
+        "",
+        "void glExtCaptureBegin(GLEXTCAPTUREWRITE* write, void* user)",
+        "{",
+        "    unsigned int header[3] = { 2, GLEXTL_PROC_COUNT, 0 };",
+        "    __glExtCaptureWrite = write;",
+        "    __glExtCaptureUser = user;",
+        "    __glExtCaptureGetIntegerv = glExt_CaptureGetIntegerv();",
+        "    __glExtRecordSize = 0;",
+        "    __glExtRecordBroken = 0;",
+        "    glExt_RecordAppend(\"GLXC\", 4);",
+        "    glExt_RecordAppend(header, sizeof(header));",
+        "    for (int i = 0; i < GLEXTL_PROC_COUNT; i++)",
+        "    {",
+        "        const char* name = __glExtProcNames + __glExtProcs[i].name;",
+        "        glExt_RecordAppend(name, strlen(name) + 1);",
+        "    }",
+        "    glExt_RecordAlign();",
+        "    if (__glExtRecordBroken || write == 0) return;",
+        "    header[2] = (unsigned int)__glExtRecordSize;",
+        "    memcpy(__glExtRecord + 12, &header[2], sizeof(header[2]));",
+        "    write(__glExtRecord, (GLsizeiptr)__glExtRecordSize, user);",
+        "    __glExtCapturing = 1;",
+        "}",
+        "",
+        "void glExtCaptureEnd(void)",
+        "{",
+        "    __glExtCapturing = 0;",
+        "    __glExtCaptureWrite = 0;",
+        "    free(__glExtRecord);",
+        "    __glExtRecord = 0;",
+        "    __glExtRecordSize = __glExtRecordCapacity = 0;",
+        "}",
+        "",
+        "// Reads the arguments of one record, a record that ends too soon is marked broken and not called, and one with client",
+        "// memory of unknown size is skipped",
+        "struct GLExtReader { const unsigned char* start; const unsigned char* p; const unsigned char* end; int broken; int skipped; };",
+        "",
+        "static void glExt_ReplayValue(struct GLExtReader* _r, void* value, size_t size)",
+        "{",
+        "    if (_r->broken || (size_t)(_r->end - _r->p) < size) { _r->broken = 1; memset(value, 0, size); return; }",
+        "    memcpy(value, _r->p, size);",
+        "    _r->p += size;",
+        "}",
+        "",
+        "// Output arguments go to scratch memory of at least 64MB",
+        "static void* __glExtReplayScratch = 0;",
+        "static size_t __glExtReplayScratchSize = 0;",
+        "static const GLchar** __glExtReplayStrings = 0;",
+        "static size_t __glExtReplayStringsSize = 0;",
+        "",
+        "static void* glExt_ReplayScratch(long long size)",
+        "{",
+        "    size_t needed = size > (64 << 20) ? (size_t)size : (size_t)(64 << 20);",
+        "    if (needed > __glExtReplayScratchSize)",
+        "    {",
+        "        free(__glExtReplayScratch);",
+        "        __glExtReplayScratch = malloc(needed);",
+        "        __glExtReplayScratchSize = __glExtReplayScratch != 0 ? needed : 0;",
+        "    }",
+        "    return __glExtReplayScratch;",
+        "}",
+        "",
+        "static const void* glExt_ReplayArray(struct GLExtReader* _r)",
+        "{",
+        "    unsigned long long bytes = 0;",
+        "    size_t offset = (size_t)(_r->p - _r->start);",
+        "    _r->p += (8 - (offset & 7)) & 7;",
+        "    if (_r->p > _r->end) { _r->p = _r->end; _r->broken = 1; }",
+        "    glExt_ReplayValue(_r, &bytes, sizeof(bytes));",
+        "    if (_r->broken || bytes == ~0ull) return 0;",
+        "    if (bytes == ~2ull) { _r->skipped = 1; return 0; }",
+        "    if (bytes == ~1ull)",
+        "    {",
+        "        unsigned long long offset = 0;",
+        "        glExt_ReplayValue(_r, &offset, sizeof(offset));",
+        "        return (const void*)(size_t)offset;",
+        "    }",
+        "    if (bytes > (unsigned long long)(_r->end - _r->p)) { _r->broken = 1; return 0; }",
+        "    const void* data = _r->p;",
+        "    _r->p += bytes;",
+        "    return data;",
+        "}",
+        "",
+        "static const GLchar* const* glExt_ReplayStrings(struct GLExtReader* _r)",
+        "{",
+        "    unsigned long long n = 0;",
+        "    size_t offset = (size_t)(_r->p - _r->start);",
+        "    _r->p += (8 - (offset & 7)) & 7;",
+        "    if (_r->p > _r->end) { _r->p = _r->end; _r->broken = 1; }",
+        "    glExt_ReplayValue(_r, &n, sizeof(n));",
+        "    if (_r->broken || n == ~0ull) return 0;",
+        "    if (n > (unsigned long long)(_r->end - _r->p) / 8) { _r->broken = 1; return 0; }",
+        "    if (n > __glExtReplayStringsSize)",
+        "    {",
+        "        const GLchar** strings = (const GLchar**)realloc((void*)__glExtReplayStrings, sizeof(const GLchar*) * (size_t)n);",
+        "        if (strings == 0) { _r->broken = 1; return 0; }",
+        "        __glExtReplayStrings = strings;",
+        "        __glExtReplayStringsSize = (size_t)n;",
+        "    }",
+        "    for (size_t i = 0; i < (size_t)n; i++) __glExtReplayStrings[i] = (const GLchar*)glExt_ReplayArray(_r);",
+        "    return __glExtReplayStrings;",
+        "}",
+        "",
+        "static void glExt_ReplayCall(int id, struct GLExtReader* _r)",
+        "{",
+        "    switch (id)",
+        "    {",
+    };
+    for (auto& call : calls) out.push_back("    " + call);
+    std::vector<std::string> rest = {
+        "    }",
+        "}",
+        "",
+        "long long glExtReplay(const void* data, GLsizeiptr size)",
+        "{",
+        "    const unsigned char* bytes = (const unsigned char*)data;",
+        "    unsigned int header[3];",
+        "    if (bytes == 0 || size < 16 || memcmp(bytes, \"GLXC\", 4) != 0) return -1;",
+        "    memcpy(header, bytes + 4, sizeof(header));",
+        "    // Every name takes at least its terminator, which bounds the count before anything is allocated for it",
+        "    if (header[0] != 2 || header[2] < 16 || header[2] > (unsigned long long)size || header[1] > header[2] - 16) return -1;",
+        "    __glExtReplayGetIntegerv = glExt_CaptureGetIntegerv();",
+        "",
+        "    // The ids of the stream are mapped to the entry points of this loader by name, the ones it does not have are skipped",
+        "    int* ids = (int*)malloc(sizeof(int) * ((size_t)header[1] + 1));",
+        "    if (ids == 0) return -1;",
+        "    const char* name = (const char*)bytes + 16;",
+        "    const char* names = (const char*)bytes + header[2];",
+        "    for (unsigned int i = 0; i < header[1]; i++)",
+        "    {",
+        "        const char* end = name < names ? (const char*)memchr(name, 0, (size_t)(names - name)) : 0;",
+        "        ids[i] = end != 0 ? glExt_FindProc(name) : -1;",
+        "        if (end != 0) name = end + 1;",
+        "    }",
+        "",
+        "    long long records = 0;",
+        "    size_t pos = header[2];",
+        "    while (records >= 0 && pos < (size_t)size)",
+        "    {",
+        "        unsigned int record[2] = { 0, 0 };",
+        "        if ((size_t)size - pos < sizeof(record)) { records = -1; break; }",
+        "        memcpy(record, bytes + pos, sizeof(record));",
+        "        if (record[0] < sizeof(record) || record[0] > (size_t)size - pos) { records = -1; break; }",
+        "",
+        "        struct GLExtReader r = { bytes + pos, bytes + pos + sizeof(record), bytes + pos + record[0], 0, 0 };",
+        "        if (record[1] < header[1] && ids[record[1]] >= 0) glExt_ReplayCall(ids[record[1]], &r);",
+        "        records = r.broken ? -1 : records + 1;",
+        "        pos += record[0];",
+        "    }",
+        "",
+        "    free(ids);",
+        "    free(__glExtReplayScratch);",
+        "    free((void*)__glExtReplayStrings);",
+        "    __glExtReplayScratch = 0;",
+        "    __glExtReplayStrings = 0;",
+        "    __glExtReplayScratchSize = __glExtReplayStringsSize = 0;",
+        "    return records;",
+        "}",
+    };
+    out.insert(out.end(), rest.begin(), rest.end());
+    return out;
+}
+
+// The entry points by name, for glExtReplay and glExtNullGetProc. The open addressing table is filled on the first
+// lookup, which should not happen from two threads at once.
+std::vector<std::string> WriteProcIndex(const std::vector<Feature>& features)
+{
+    size_t count = 0, slots = 1;
+    for (auto& feature : features) count += feature.mapped.size();
+    while (slots < 2 * count) slots <<= 1;
+    std::string mask = std::to_string(slots - 1) + "u";
+
+    return {
+        "#define GLEXTL_PROC_COUNT " + std::to_string(count),
+        "",
+        "static int __glExtProcIndex[" + std::to_string(slots) + "];",
+        "static int __glExtProcIndexBuilt = 0;",
+        "",
+        "static unsigned int glExt_HashProcName(const char* name)",
+        "{",
+        "    unsigned int hash = 2166136261u;",
+        "    for (; *name != 0; ++name) hash = (hash ^ (unsigned char)*name) * 16777619u;",
+        "    return hash;",
+        "}",
+        "",
+        "static int glExt_FindProc(const char* name)",
+        "{",
+        "    if (!__glExtProcIndexBuilt)",
+        "    {",
+        "        memset(__glExtProcIndex, 0xff, sizeof(__glExtProcIndex));",
+        "        for (int i = 0; i < GLEXTL_PROC_COUNT; i++)",
+        "        {",
+        "            unsigned int s = glExt_HashProcName(__glExtProcNames + __glExtProcs[i].name) & " + mask + ";",
+        "            while (__glExtProcIndex[s] >= 0) s = (s + 1) & " + mask + ";",
+        "            __glExtProcIndex[s] = i;",
+        "        }",
+        "        __glExtProcIndexBuilt = 1;",
+        "    }",
+        "    for (unsigned int s = glExt_HashProcName(name) & " + mask + "; __glExtProcIndex[s] >= 0; s = (s + 1) & " + mask + ")",
+        "        if (strcmp(__glExtProcNames + __glExtProcs[__glExtProcIndex[s]].name, name) == 0) return __glExtProcIndex[s];",
+        "    return -1;",
+        "}",
+    };
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Null backend
+////////////////////////////////////////////////////////////////////////////////////////////
+// Object names are handed out by the functions that create objects or handles
+bool createsNames(std::string_view function)
+{
+    return function.compare(0, 5, "glGen") == 0 || function.compare(0, 8, "glCreate") == 0 || function.find("Handle") != std::string_view::npos;
+}
+
+// A stub that counts its calls and gives believable answers, for the GL without a GPU behind glExtNullGetProc
+void WriteNullFunction(std::string& out, const Prototype& prototype, size_t id)
+{
+    auto& name = prototype.name;
+    auto& decl = prototype.decl;
+    std::string_view returnType = returnTypeOf(decl);
+    std::string_view::size_type pos = decl.find("APIENTRY ") + std::string_view("APIENTRY ").size();
+    auto params = CaptureParameters(name, decl);
+
+    auto value = [&](std::string_view n) { return std::any_of(params.begin(), params.end(), [&](auto& p) { return p.name == n; }); };
+
+    std::string body = "__glExtNullCalls[" + std::to_string(id) + "]++; ";
+
+    // Outputs get names, an empty string, or the answer to their pname in the first element
+    for (auto& p : params)
+    {
+        if (p.kind != CaptureKind::Output || std::count(p.type.begin(), p.type.end(), '*') != 1) continue;
+        if ((p.element == "GLuint" || p.element == "GLuint64") && createsNames(name) && !p.count.empty())
+            append(body, "glExt_NullNames(", p.count, ", (GLuint*)", p.name, "); ");
+        else if (p.element == "GLchar" || p.element == "GLcharARB")
+        {
+            if (!p.count.empty()) append(body, "if (", p.name, " != 0 && ", p.count, " > 0) ", p.name, "[0] = 0; ");
+        }
+        else if (p.element.compare(0, 2, "GL") == 0 && p.element != "GLvoid" && p.element != "GLsync")
+            append(body, "if (", p.name, " != 0) *", p.name, " = (", p.element, ")glExt_NullValue(", (value("pname") ? "pname" : "0"), "); ");
+    }
+
+    if (name == "glGetString")
+        body.append("return glExt_NullGetString(name); ");
+    else if (name == "glGetStringi")
+        body.append("return glExt_NullGetStringi(name, index); ");
+    else if (returnType.find('*') != std::string_view::npos || returnType == "GLsync")
+        append(body, "return (", returnType, ")glExt_NullMemory(", (value("length") ? "length" : "0"), "); ");
+    else if (returnType == "GLboolean")
+        body.append("return GL_TRUE; ");
+    else if (returnType == "GLenum")
+    {
+        // Framebuffers are complete, fences are signaled and there are no errors
+        std::string result = "0";
+        if (name.find("CheckFramebufferStatus") != std::string_view::npos || name.find("CheckNamedFramebufferStatus") != std::string_view::npos) result = "0x8CD5";
+        else if (name.find("ClientWaitSync") != std::string_view::npos) result = "0x911A";
+        append(body, "return ", result, "; ");
+    }
+    else if (returnType != "void")
+        append(body, "return (", returnType, ")", (createsNames(name) ? "glExt_NullName()" : "0"), "; ");
+
+    body.append("}\n");
+
+    out.append("static ");
+    writeDeclaration(out, std::string(decl.substr(0, pos)) + "__glExtNull" + std::string(name) + std::string(decl.substr(pos + name.size())));
+    append(out, " { ", voidUnused(params, body), body);
+}
+
+std::vector<std::string> WriteNullBackend(const std::vector<Feature>& features)
+{
+    std::string stubs;
+    std::vector<std::string> procs;
+    size_t count = 0;
+    for (auto& feature : features)
+    {
+        for (auto& mappedPrototype : feature.mapped)
+        {
+            procs.push_back("(void*)__glExtNull" + std::string(mappedPrototype.first.name));
+            WriteNullFunction(stubs, mappedPrototype.first, count++);
+        }
+    }
+    if (procs.empty()) procs.push_back("0");
+    if (!stubs.empty()) stubs.pop_back();
+
+    // The extensions of the loader are advertised by their feature index, the GL_VERSION_x_y features are not extensions
+    std::vector<std::string> extensions;
+    for (size_t i = 0; i < features.size(); i++)
+    {
+        int major, minor;
+        if (!ParseVersionFeature(features[i].name, major, minor)) extensions.push_back(std::to_string(i));
+    }
+    std::string extensionCount = std::to_string(extensions.size());
+    if (extensions.empty()) extensions.push_back("0");
+    std::string extension = features.empty() ? "\"\"" : "__glExtFeatureNames + __glExtFeatureNameOffsets[__glExtNullExtensions[index]]";
+
+    std::vector<std::string> out = {
+        "#define GLEXTL_NULL_EXTENSIONS " + extensionCount,
+        WriteTable("static const int __glExtNullExtensions[" + std::to_string(extensions.size()) + "]", extensions, 16),
+        "static unsigned long long __glExtNullCalls[GLEXTL_PROC_COUNT + 1];",
+        "static GLuint __glExtNullLastName = 0;",
+        "static void** __glExtNullMemory = 0;",
+        "static size_t __glExtNullMemorySize = 0;",
+        "",
+        "static GLuint glExt_NullName(void)",
+        "{",
+        "    return ++__glExtNullLastName;",
+        "}",
+        "",
+        "static void glExt_NullNames(GLsizei n, GLuint* names)",
+        "{",
+        "    for (GLsizei i = 0; names != 0 && i < n; i++) names[i] = glExt_NullName();",
+        "}",
+        "",
+        "// Zeroed memory for maps and other returned pointers, at least 64MB, shared by all of them. A larger request gets a",
+        "// new block after the first word of it, which links to the earlier blocks. Those are only freed by glExtNullReset,",
+        "// so the pointers of maps that are still open stay valid.",
+        "static void* glExt_NullMemory(long long size)",
+        "{",
+        "    size_t needed = size > (64 << 20) ? (size_t)size : (size_t)(64 << 20);",
+        "    if (needed > __glExtNullMemorySize)",
+        "    {",
+        "        void** block = (void**)calloc(needed + sizeof(void*), 1);",
+        "        if (block == 0) return 0;",
+        "        block[0] = __glExtNullMemory;",
+        "        __glExtNullMemory = block;",
+        "        __glExtNullMemorySize = needed;",
+        "    }",
+        "    return __glExtNullMemory + 1;",
+        "}",
+        "",
+        "// Compiles, links and queries succeed, and the context is 4.6 with all extensions of the loader",
+        "static long long glExt_NullValue(GLenum pname)",
+        "{",
+        "    switch (pname)",
+        "    {",
+        "    case 0x8B81: case 0x8B82: case 0x8B83: case 0x91B1: case 0x8867: return 1;",
+        "    case 0x84E0: return 0x84C0;",
+        "    case 0x821B: return 4;",
+        "    case 0x821C: return 6;",
+        "    case 0x821D: return GLEXTL_NULL_EXTENSIONS;",
+        "    case 0x9114: return 0x9119;",
+        "    }",
+        "    return 0;",
+        "}",
+        "",
+        "static const GLubyte* APIENTRY glExt_NullGetString(GLenum name)",
+        "{",
+        "    switch (name)",
+        "    {",
+        "    case 0x1F00: return (const GLubyte*)\"glextl\";",
+        "    case 0x1F01: return (const GLubyte*)\"glextl null backend\";",
+        "    case 0x1F02: return (const GLubyte*)\"4.6.0 glextl null backend\";",
+        "    case 0x8B8C: return (const GLubyte*)\"4.60\";",
+        "    }",
+        "    return (const GLubyte*)\"\";",
+        "}",
+        "",
+        "static const GLubyte* APIENTRY glExt_NullGetStringi(GLenum name, GLuint index)",
+        "{",
+        "    if (name != 0x1F03 || index >= GLEXTL_NULL_EXTENSIONS) return 0;",
+        "    return (const GLubyte*)(" + extension + ");",
+        "}",
+        "",
+        "static void APIENTRY glExt_NullGetIntegerv(GLenum pname, GLint* data)",
+        "{",
+        "    if (data != 0) *data = (GLint)glExt_NullValue(pname);",
+        "}",
+        "",
+        stubs,
+        "",
+    };
+
+    auto table = WriteTable("static void* const __glExtNullProcs[" + std::to_string(procs.size()) + "]", procs, 1);
+    std::vector<std::string> rest = {
+        table,
+        "",
+        "// The queries of the loader itself are answered even when they are not part of it, like glGetString with glext.h",
+        "void* glExtNullGetProc(const GLubyte* name)",
+        "{",
+        "    int i = name != 0 ? glExt_FindProc((const char*)name) : -1;",
+        "    if (i >= 0) return __glExtNullProcs[i];",
+        "    if (name == 0) return 0;",
+        "    if (strcmp((const char*)name, \"glGetString\") == 0) return (void*)glExt_NullGetString;",
+        "    if (strcmp((const char*)name, \"glGetStringi\") == 0) return (void*)glExt_NullGetStringi;",
+        "    if (strcmp((const char*)name, \"glGetIntegerv\") == 0) return (void*)glExt_NullGetIntegerv;",
+        "    return 0;",
+        "}",
+        "",
+        "unsigned long long glExtNullCalls(const char* name)",
+        "{",
+        "    unsigned long long total = 0;",
+        "    if (name != 0)",
+        "    {",
+        "        int i = glExt_FindProc(name);",
+        "        return i >= 0 ? __glExtNullCalls[i] : 0;",
+        "    }",
+        "    for (int i = 0; i < GLEXTL_PROC_COUNT; i++) total += __glExtNullCalls[i];",
+        "    return total;",
+        "}",
+        "",
+        "void glExtNullReset(void)",
+        "{",
+        "    memset(__glExtNullCalls, 0, sizeof(__glExtNullCalls));",
+        "    __glExtNullLastName = 0;",
+        "    while (__glExtNullMemory != 0)",
+        "    {",
+        "        void** next = (void**)__glExtNullMemory[0];",
+        "        free(__glExtNullMemory);",
+        "        __glExtNullMemory = next;",
+        "    }",
+        "    __glExtNullMemorySize = 0;",
+        "}",
+    };
+    out.insert(out.end(), rest.begin(), rest.end());
+    return out;
+}
+
+// The declarations of the null backend for glextl.h, only written when the generator runs with --null
+std::vector<std::string> WriteNullDeclarations()
+{
+    return {
+        "// Only with GLEXTL_NULL defined for the implementation: a GL without a GPU, for tests and benchmarks. Pass",
+        "// glExtNullGetProc to a load function and every entry point only counts its calls. Objects get increasing names,",
+        "// compiles, links and status queries succeed, the context is 4.6 with every extension of the loader, and maps",
+        "// return zeroed memory that stays valid until glExtNullReset. glExtNullCalls returns the calls of one entry point,",
+        "// or of all of them for a null name.",
+        "void* glExtNullGetProc(const GLubyte* name);",
+        "unsigned long long glExtNullCalls(const char* name);",
+        "void glExtNullReset(void);",
+    };
+}
+
+// Groups the feature implementations into separate files. With parts == 0 every feature gets its own file,
+// otherwise the features are spread over that many files of about the same size, in header order.
+std::vector<std::string> WriteFeatureParts(const std::vector<Feature>& features, int parts, int jobs, bool capture, const std::vector<std::string>& hot)
+{
+    std::vector<std::string> written(features.size());
+    std::vector<size_t> first = FirstEntryPoints(features);
+    std::set<std::string_view> hotNames = HotNames(features, hot);
+    ParallelFor(features.size(), jobs, [&](size_t i)
+    {
+        WriteFeatureImplementation(written[i], features[i], first[i], capture, hotNames);
+        written[i].append("\n");
+    });
+
+    // The hot wrappers go first, in a file of their own when every feature gets one
+    std::string hotWrappers;
+    WriteHotImplementation(hotWrappers, features, capture, hot);
+    if (!hotWrappers.empty()) written.insert(written.begin(), std::move(hotWrappers));
+
+    if (parts <= 0) return written;
+
+    size_t size = 0;
+    for (auto& w : written) size += w.size();
+
+    std::vector<std::string> result(static_cast<size_t>(parts));
+    size_t done = 0;
+    for (auto& w : written)
+    {
+        // Move on to the next file when this one has its share of the total
+        size_t part = std::min(size_t(parts) - 1, size_t(parts) * done / std::max(size, size_t(1)));
+        result[part] += w;
+        done += w.size();
+    }
+
+    return result;
+}
+
+std::string WriteFeatures(const std::vector<Feature>& features, const Aliases& aliases, int jobs, bool implementations, bool capture, bool nullBackend, const std::vector<std::string>& hot)
 {
-    std::stringstream out;
+    std::string out;
 
     // Write Headers and proc loader
     Writer()
-            .Statement("PFNGLGETPROC* __glExt_GetProcAddress = 0;")
+            // Write the contexts, threads start out with the default context
+            .Statement("static struct GLExtContext __glExtDefaultContext;")
+            .Statement("GLEXTL_THREAD_LOCAL struct GLExtContext* __glExtCurrent = &__glExtDefaultContext;")
+            .EmptyLine()
+            .Statement("struct GLExtContext* glExtCreateContext(void)")
+            .Enter(Writer()
+                   .Statement("return (struct GLExtContext*)calloc(1, sizeof(struct GLExtContext));")
+                   )
+            .EmptyLine()
+            .Statement("void glExtDestroyContext(struct GLExtContext* context)")
+            .Enter(Writer()
+                   .Statement("if (context == 0 || context == &__glExtDefaultContext) return;")
+                   .Statement("if (__glExtCurrent == context) __glExtCurrent = &__glExtDefaultContext;")
+                   .Statement("free(context->otherExtensions);")
+                   .Statement("free(context);")
+                   )
+            .EmptyLine()
+            .Statement("void glExtMakeCurrent(struct GLExtContext* context)")
+            .Enter(Writer()
+                   .Statement("__glExtCurrent = context != 0 ? context : &__glExtDefaultContext;")
+                   )
+            .EmptyLine()
+            .Statement("struct GLExtContext* glExtGetCurrentContext(void)")
+            .Enter(Writer()
+                   .Statement("return __glExtCurrent;")
+                   )
+            .EmptyLine()
+            .Statement("static GLboolean __glExtSetLoaded(int id, GLboolean loaded)")
+            .Enter(Writer()
+                   .Statement("if (loaded) __glExtCurrent->loaded[id >> 5] |= 1u << (id & 31);")
+                   .Statement("else __glExtCurrent->loaded[id >> 5] &= ~(1u << (id & 31));")
+                   .Statement("return loaded;")
+                   )
+            .EmptyLine()
             .Statement("void* glExt_GetProcAddress(const GLubyte* name)")
             .Enter(Writer()
-                   .Statement("if(__glExt_GetProcAddress != 0) return (*__glExt_GetProcAddress)(name);")
+                   .Statement("if(__glExtCurrent->proc != 0) return (*__glExtCurrent->proc)(name);")
                    .Statement("return 0;")
                    )
+            .Statement("void* glExt_ResolveProc(int i);")
             .EmptyLine()
 
             // Write Foreach Extension
-            .Statement(WriteAllFeatures(features))
+            .Statement(WriteAllFeatures(features, jobs, implementations, capture, hot))
+            .EmptyLine()
+
+            // Write the tables the features are loaded from
+            .Statement(WriteProcTables(features, aliases))
+            .EmptyLine()
+
+            // Write the call counters
+            .IfDef("GLEXTL_PROFILE", Writer()
+                   .Statement(WriteProfiler(features))
+                   )
+            .EmptyLine()
+
+            // Write the feature lookup by name
+            .Statement(WriteFeatureLookup(features))
+            .EmptyLine()
+
+            // Write the context queries, the functions are looked up like the rest, or come from gl.h when they are not part of the loader
+            .Statement("typedef const GLubyte* (APIENTRY *PFNGLEXTGETSTRINGPROC)(GLenum name);")
+            .Statement("typedef const GLubyte* (APIENTRY *PFNGLEXTGETSTRINGIPROC)(GLenum name, GLuint index);")
+            .Statement("typedef void (APIENTRY *PFNGLEXTGETINTEGERVPROC)(GLenum pname, GLint* data);")
+            .Statement("static const GLubyte* glExt_GetString(GLenum name)")
+            .Enter(Writer()
+                   .Statement("PFNGLEXTGETSTRINGPROC getString = (PFNGLEXTGETSTRINGPROC)glExt_GetProcAddress((const GLubyte*)\"glGetString\");")
+                   .Statement("#ifndef __glcorearb_h_")
+                   .Statement("if (getString == 0) getString = glGetString;")
+                   .Statement("#endif")
+                   .Statement("return getString != 0 ? getString(name) : 0;")
+                   )
+            .EmptyLine()
+
+            // Write the extension set, the advertised extensions are kept as bits by feature id, and by name when the
+            // loader has no feature for them
+            .Statement("static void glExt_SetSupported(const char* name, size_t length)")
+            .Enter(Writer()
+                   .Statement("char buffer[128];")
+                   .Statement("if (length == 0 || length >= sizeof(buffer)) return;")
+                   .Statement("memcpy(buffer, name, length);")
+                   .Statement("buffer[length] = 0;")
+                   .Statement("int i = glExt_FeatureIndex(buffer);")
+                   .Statement("if (i >= 0)")
+                   .Enter(Writer()
+                          .Statement("__glExtCurrent->supported[i >> 5] |= 1u << (i & 31);")
+                          .Statement("return;")
+                          )
+                   .Statement("char* others = (char*)realloc(__glExtCurrent->otherExtensions, __glExtCurrent->otherLength + length + 1);")
+                   .Statement("if (others == 0) return;")
+                   .Statement("memcpy(others + __glExtCurrent->otherLength, buffer, length + 1);")
+                   .Statement("__glExtCurrent->otherExtensions = others;")
+                   .Statement("__glExtCurrent->otherLength += (GLuint)length + 1;")
+                   )
+            .EmptyLine()
+            .Statement("static void glExt_ReadExtensions(void)")
+            .Enter(Writer()
+                   .Statement("memset(__glExtCurrent->supported, 0, sizeof(__glExtCurrent->supported));")
+                   .Statement("free(__glExtCurrent->otherExtensions);")
+                   .Statement("__glExtCurrent->otherExtensions = 0;")
+                   .Statement("__glExtCurrent->otherLength = 0;")
+                   .Statement("__glExtCurrent->extensionsRead = GL_FALSE;")
+                   .EmptyLine()
+                   .Statement("PFNGLEXTGETSTRINGIPROC getStringi = (PFNGLEXTGETSTRINGIPROC)glExt_GetProcAddress((const GLubyte*)\"glGetStringi\");")
+                   .Statement("PFNGLEXTGETINTEGERVPROC getIntegerv = (PFNGLEXTGETINTEGERVPROC)glExt_GetProcAddress((const GLubyte*)\"glGetIntegerv\");")
+                   .Statement("#ifndef __glcorearb_h_")
+                   .Statement("if (getIntegerv == 0) getIntegerv = glGetIntegerv;")
+                   .Statement("#endif")
+                   .Statement("GLint count = 0;")
+                   .Statement("if (getStringi != 0 && getIntegerv != 0) getIntegerv(GL_NUM_EXTENSIONS, &count);")
+                   .Statement("if (count > 0)")
+                   .Enter(Writer()
+                          .Statement("for (GLint i = 0; i < count; i++)")
+                          .Enter(Writer()
+                                 .Statement("const char* name = (const char*)getStringi(GL_EXTENSIONS, (GLuint)i);")
+                                 .Statement("if (name != 0) glExt_SetSupported(name, strlen(name));")
+                                 )
+                          .Statement("__glExtCurrent->extensionsRead = GL_TRUE;")
+                          .Statement("return;")
+                          )
+                   .EmptyLine()
+                   .Statement("// Contexts before 3.0 only have all names in one string")
+                   .Statement("const char* all = (const char*)glExt_GetString(GL_EXTENSIONS);")
+                   .Statement("if (all == 0) return;")
+                   .Statement("while (*all != 0)")
+                   .Enter(Writer()
+                          .Statement("const char* end = all;")
+                          .Statement("while (*end != 0 && *end != ' ') end++;")
+                          .Statement("glExt_SetSupported(all, (size_t)(end - all));")
+                          .Statement("all = *end != 0 ? end + 1 : end;")
+                          )
+                   .Statement("__glExtCurrent->extensionsRead = GL_TRUE;")
+                   )
+            .EmptyLine()
+
+            // When the extensions could not be read, every extension is tried
+            .Statement("static GLboolean glExt_Advertised(int id)")
+            .Enter(Writer()
+                   .Statement("return !__glExtCurrent->extensionsRead || ((__glExtCurrent->supported[id >> 5] >> (id & 31)) & 1u);")
+                   )
+            .EmptyLine()
+
+            // Write glExtIsSupported
+            .Statement("GLboolean glExtIsSupported(const char* name)")
+            .Enter(Writer()
+                   .Statement("int i = glExt_FeatureIndex(name);")
+                   .Statement("if (i >= 0) return glExtIsSupportedId((enum GLExtFeature)i);")
+                   .Statement("if (name == 0) return GL_FALSE;")
+                   .EmptyLine()
+                   .Statement("// Extensions the loader was generated without, for example with --extensions or --scan")
+                   .Statement("for (GLuint at = 0; at < __glExtCurrent->otherLength; at += (GLuint)strlen(__glExtCurrent->otherExtensions + at) + 1)")
+                   .Statement("    if (strcmp(__glExtCurrent->otherExtensions + at, name) == 0) return GL_TRUE;")
+                   .Statement("return GL_FALSE;")
+                   )
             .EmptyLine()
 
             // Write glExtLoadAll
             .Statement("GLboolean glExtLoadAll(PFNGLGETPROC* proc)")
             .Enter(Writer()
-                   .Statement("__glExt_GetProcAddress = proc;")
-                   .Statement(WriteFeaturesForLoadAll(features))
+                   .Statement("__glExtCurrent->proc = proc;")
+                   .Statement("glExt_ReadExtensions();")
+                   .EmptyLine()
+                   .Statement("// Extensions are only looked up when the driver advertises them")
+                   .Statement("for (int i = 0; i < GLEXTL_FEATURE_COUNT; i++)")
+                   .Statement("    __glExtSetLoaded(i, (__glExtFeatureVersions[i] != 0 || glExt_Advertised(i)) && glExt_LoadFeature(i));")
                    .Statement("return GL_TRUE;")
                    )
             .EmptyLine()
 
+            // Write glExtLoadCore
+            .Statement("static int glExt_ContextVersion(void)")
+            .Enter(Writer()
+                   .Statement("const GLubyte* v = glExt_GetString(GL_VERSION);")
+                   .Statement("if (v == 0) return 0;")
+                   .EmptyLine()
+                   .Statement("// \"4.6.0 Vendor\" or \"OpenGL ES 3.2 Vendor\", as major * 100 + minor")
+                   .Statement("int major = 0, minor = 0;")
+                   .Statement("while (*v != 0 && (*v < '0' || *v > '9')) v++;")
+                   .Statement("while (*v >= '0' && *v <= '9') major = major * 10 + (*v++ - '0');")
+                   .Statement("if (*v != '.') return 0;")
+                   .Statement("for (v++; *v >= '0' && *v <= '9'; v++) minor = minor * 10 + (*v - '0');")
+                   .Statement("return major * 100 + minor;")
+                   )
+            .EmptyLine()
+            .Statement("GLboolean glExtLoadCore(PFNGLGETPROC* proc)")
+            .Enter(Writer()
+                   .Statement("__glExtCurrent->proc = proc;")
+                   .Statement("int version = glExt_ContextVersion();")
+                   .Statement("if (version == 0) return GL_FALSE;")
+                   .EmptyLine()
+                   .Statement("// The versions above the context are cleared, they may be left from a context that had them")
+                   .Statement("GLboolean r = GL_TRUE;")
+                   .Statement("for (int i = 0; i < GLEXTL_FEATURE_COUNT; i++)")
+                   .Enter(Writer()
+                          .Statement("if (__glExtFeatureVersions[i] == 0) continue;")
+                          .Statement("if (__glExtFeatureVersions[i] <= version) r = __glExtSetLoaded(i, glExt_LoadFeature(i)) && r;")
+                          .Statement("else __glExtSetLoaded(i, GL_FALSE);")
+                          )
+                   .Statement("return r;")
+                   )
+            .EmptyLine()
+
+            // Write glExtLoadLazy
+            .IfDef("GLEXTL_LAZY", Writer()
+                   .Statement("GLboolean glExtLoadLazy(PFNGLGETPROC* proc)")
+                   .Enter(Writer()
+                          .Statement("__glExtCurrent->proc = proc;")
+                          .Statement(WriteFeaturesForLoadLazy(features))
+                          .Statement("return GL_TRUE;")
+                          )
+                   )
+            .EmptyLine()
+
             // Write glExtLoadOne
             .Statement("GLboolean glExtLoadOne(PFNGLGETPROC* proc, const char* name)")
             .Enter(Writer()
-                   .Statement("__glExt_GetProcAddress = proc;")
-                   .Statement(WriteFeaturesFor_LoadOne(features))
-                   .Statement("return GL_FALSE;")
+                   .Statement("__glExtCurrent->proc = proc;")
+                   .Statement("int i = glExt_FeatureIndex(name);")
+                   .Statement("if (i < 0) return GL_FALSE;")
+                   .Statement("if (!__glExtCurrent->extensionsRead) glExt_ReadExtensions();")
+                   .Statement("GLboolean loaded = (__glExtFeatureVersions[i] != 0 || glExt_Advertised(i)) && glExt_LoadFeature(i);")
+                   .Statement("__glExtSetLoaded(i, loaded);")
+                   .Statement("return loaded;")
                    )
             .EmptyLine()
 
             // Write glExtIsLoaded
             .Statement("GLboolean glExtIsLoaded(const char* name)")
             .Enter(Writer()
-                   .Statement(WriteFeaturesFor_IsLoaded(features))
-                   .Statement("return GL_FALSE;")
+                   .Statement("int i = glExt_FeatureIndex(name);")
+                   .Statement("if (i < 0) return GL_FALSE;")
+                   .Statement("return glExtIsLoadedId((enum GLExtFeature)i);")
+                   )
+            .EmptyLine()
+
+            // Write glExtLoadedBits
+            .Statement("const GLuint* glExtLoadedBits(void)")
+            .Enter(Writer()
+                   .Statement("return __glExtCurrent->loaded;")
+                   )
+            .Write(out);
+
+    // Write the state filter, after the context queries it reads the active texture unit with
+    Writer()
+            .EmptyLine()
+            .IfDef("GLEXTL_FILTER", Writer()
+                   .Statement(WriteFilter())
                    )
             .Write(out);
 
-    return out.str();
+    // Write the wrappers of the gl.h functions it filters, with or without GLEXTL_FILTER like the other wrappers
+    std::vector<std::string> filterWrappers = WriteFilterWrappers(features);
+    if (!filterWrappers.empty())
+        Writer()
+                .EmptyLine()
+                .IfNotDef("GLEXTL_DIRECT_DISPATCH", Writer()
+                       .Statement(filterWrappers)
+                       )
+                .Write(out);
+
+    // Write the lookup by name that both of them use
+    if (capture || nullBackend)
+        Writer()
+                .EmptyLine()
+                .Statement("#if defined(GLEXTL_CAPTURE) || defined(GLEXTL_NULL)")
+                .Statement(WriteProcIndex(features))
+                .Statement("#endif")
+                .Write(out);
+
+    // Write the capture layer and glExtReplay, which use the tables and context queries above
+    if (capture)
+        Writer()
+                .EmptyLine()
+                .IfDef("GLEXTL_CAPTURE", Writer()
+                       .Statement(WriteCapture(features))
+                       )
+                .Write(out);
+
+    // Write the null backend
+    if (nullBackend)
+        Writer()
+                .EmptyLine()
+                .IfDef("GLEXTL_NULL", Writer()
+                       .Statement(WriteNullBackend(features))
+                       )
+                .Write(out);
+
+    return out;
+}
+
+// The declarations of glextl.h: the feature ids, the dispatch table and everything the application calls
+Writer WriteDeclarations(const std::vector<Feature>& features, const GeneratorOptions& options)
+{
+    // glcorearb.h replaces gl.h, and brings its own GL_VERSION_1_0 and GL_VERSION_1_1 which are loaded like the rest
+    std::vector<std::string> includes;
+    if (options.profile == "core")
+        includes = { "#define GL_GLEXT_PROTOTYPES", "#include <GL/glcorearb.h>" };
+    else
+        includes = { "#include <GL/gl.h>", "#define GL_GLEXT_PROTOTYPES", "#include <GL/glext.h>" };
+
+    Writer declarations;
+    declarations
+            .Statement("#define GLEXTL_H")
+            .Statement(includes)
+            .EmptyLine()
+            .Statement("typedef void* (PFNGLGETPROC)(const GLubyte* name);")
+            .EmptyLine()
+            .Statement(WriteFeatureIds(features))
+            .EmptyLine()
+            .Statement("// All function pointers in one table per context, with the calls of the draw loop next to each other")
+            .Statement(WriteDispatchTable(features, options.hot))
+            .EmptyLine()
+            .Statement("GLboolean glExtLoadAll(PFNGLGETPROC* proc);")
+            .Statement("// Only loads the GL_VERSION_x_y features up to the version of the current GL context, and no extensions")
+            .Statement("GLboolean glExtLoadCore(PFNGLGETPROC* proc);")
+            .Statement("GLboolean glExtLoadOne(PFNGLGETPROC* proc, const char* name);")
+            .Statement("GLboolean glExtIsLoaded(const char* name);")
+            .EmptyLine()
+            .Statement("// Whether the driver advertises an extension, as read by the last glExtLoadAll or glExtLoadOne of the current context.")
+            .Statement("// Extensions are only loaded when they are advertised, unless the extensions of the context could not be read.")
+            .Statement("GLboolean glExtIsSupported(const char* name);")
+            .Statement("static inline GLboolean glExtIsSupportedId(enum GLExtFeature id) { return (GLboolean)((__glExtCurrent->supported[id >> 5] >> (id & 31)) & 1u); }")
+            .EmptyLine()
+            .Statement("// Only with GLEXTL_LAZY defined for the implementation: points every entry point at a stub that looks it up on its")
+            .Statement("// first call, so only the functions that are used are looked up. It does not set the loaded flags.")
+            .Statement("GLboolean glExtLoadLazy(PFNGLGETPROC* proc);")
+            .EmptyLine()
+            .Statement("// A context has its own function pointers and loaded flags, the load functions above fill the current one.")
+            .Statement("// Every thread starts with the default context, make another one current to load and call it from that thread.")
+            .Statement("struct GLExtContext* glExtCreateContext(void);")
+            .Statement("void glExtDestroyContext(struct GLExtContext* context);")
+            .Statement("void glExtMakeCurrent(struct GLExtContext* context);")
+            .Statement("struct GLExtContext* glExtGetCurrentContext(void);")
+            .EmptyLine()
+            .Statement("// All loaded flags as a bitset of GLEXTL_FEATURE_WORDS words, bit (id & 31) of word (id >> 5) is feature id")
+            .Statement("const GLuint* glExtLoadedBits(void);")
+            .Statement("static inline GLboolean glExtIsLoadedId(enum GLExtFeature id) { return (GLboolean)((__glExtCurrent->loaded[id >> 5] >> (id & 31)) & 1u); }")
+            .EmptyLine()
+            .Statement("// Only with GLEXTL_PROFILE defined for the implementation: the number of calls and the time spent in every entry")
+            .Statement("// point that is called through the gl* functions. A snapshot is sorted by time, most first, and returns how many")
+            .Statement("// entry points were called. The report is a text table or JSON and returns its length, like snprintf.")
+            .Statement("struct GLExtProfileEntry { const char* name; unsigned long long calls; unsigned long long nanoseconds; };")
+            .Statement("int glExtProfileSnapshot(struct GLExtProfileEntry* entries, int count);")
+            .Statement("void glExtProfileReset(void);")
+            .Statement("int glExtProfileReport(char* buffer, int size, GLboolean json);")
+            .Statement("unsigned long long glExt_ProfileNow(void);")
+            .Statement("void glExt_ProfileAdd(int id, unsigned long long start);")
+            .Statement("#ifdef GLEXTL_PROFILE")
+            .Statement("#define GLEXTL_PROFILE_BEGIN unsigned long long __start = glExt_ProfileNow();")
+            .Statement("#define GLEXTL_PROFILE_END(id) glExt_ProfileAdd(id, __start);")
+            .Statement("#else")
+            .Statement("#define GLEXTL_PROFILE_BEGIN")
+            .Statement("#define GLEXTL_PROFILE_END(id)")
+            .Statement("#endif")
+            .EmptyLine()
+            .Statement(WriteFilterDeclarations(features))
+            .EmptyLine()
+            .Statement(options.capture ? WriteCaptureDeclarations() : std::vector<std::string>())
+            .Statement(options.nullBackend ? WriteNullDeclarations() : std::vector<std::string>())
+            .Statement("// Define GLEXTL_DIRECT_DISPATCH everywhere to call through the dispatch table, without a wrapper and null check")
+            .Statement(WriteDirectDispatch(features, options.hot))
+            .EmptyLine();
+    return declarations;
+}
+
+// The implementation in glextl.h, behind its guard so it is only compiled once
+Writer WriteImplementation(std::string implementation)
+{
+    Writer out;
+    out
+            .Statement("#define _GLEXTL_IMPLEMENTATION_GUARD_")
+            .Statement("#include <stdlib.h>")
+            .Statement("#include <stddef.h>")
+            .Statement("#include <stdio.h>")
+            .Statement("#include <string.h>")
+            .Statement(std::move(implementation));
+    return out;
+}
+
+// Writes glextl.h: the declarations, followed by the implementation behind GLEXTL_IMPLEMENTATION unless it is null
+void WriteHeader(std::string& out, Writer& declarations, Writer* implementation)
+{
+    if (implementation == nullptr)
+    {
+        Writer()
+                .IfNotDef("GLEXTL_H", declarations)
+                .Write(out);
+        return;
+    }
+
+    Writer()
+            // Write Declaration
+            .IfNotDef("GLEXTL_H", declarations)
+            .EmptyLine()
+
+            // Write implementation
+            .IfDef("GLEXTL_IMPLEMENTATION", Writer()
+                   .IfNotDef("_GLEXTL_IMPLEMENTATION_GUARD_", *implementation)
+                   )
+            .Write(out);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Output file helpers
+////////////////////////////////////////////////////////////////////////////////////////////
+void WriteCacheFile(const std::string& filename, unsigned long long hash, const std::vector<std::string>& outputs)
+{
+    std::ofstream out(filename.c_str());
+    out << std::hex << hash << std::endl;
+    for (auto& output : outputs) out << output << std::endl;
+}
+
+bool WriteFileIfChanged(const std::string& filename, const std::string& contents, bool& written)
+{
+    written = false;
+    {
+        MappedFile existing(filename);
+        if (existing.IsOpen() && existing.View() == contents) return true;
+    }
+
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    if (!out.is_open()) return false;
+
+    out.write(contents.data(), std::streamsize(contents.size()));
+    written = true;
+    return out.good();
 }
 
 
@@ -124,77 +2635,98 @@ std::string WriteFeatures(const std::vector<Feature>& features)
 ////////////////////////////////////////////////////////////////////////////////////////////
 static Writer empty;
 
-Writer::StatementChild::StatementChild(Writer& scope) : _scope(scope), _type(1) { }
-Writer::StatementChild::StatementChild(const std::string& statement) : _scope(empty), _statement(statement), _type(0) { }
-Writer::StatementChild::StatementChild(const std::string& statement, Writer& scope, int t) : _scope(scope), _statement(statement), _type(t) { }
+Writer::StatementChild::StatementChild(Writer& scope, int t) : _type(t), _scope(scope) { }
+Writer::StatementChild::StatementChild(std::string statement) : _type(0), _scope(empty), _statement(std::move(statement)) { }
+Writer::StatementChild::StatementChild(std::string statement, Writer& scope, int t) : _type(t), _scope(scope), _statement(std::move(statement)) { }
 
-Writer& Writer::IfDef(const std::string& statement, Writer& child)
+Writer& Writer::IfDef(std::string statement, Writer& child)
 {
-    this->_children.push_back(StatementChild(statement, child, 2));
+    this->_children.push_back(StatementChild(std::move(statement), child, 2));
     return *this;
 }
 
-Writer& Writer::IfNotDef(const std::string& statement, Writer& child)
+Writer& Writer::IfNotDef(std::string statement, Writer& child)
 {
-    this->_children.push_back(StatementChild(statement, child, 3));
+    this->_children.push_back(StatementChild(std::move(statement), child, 3));
     return *this;
 }
 
-Writer& Writer::Statement(const std::string &statement)
+Writer& Writer::Statement(std::string statement)
 {
-    this->_children.push_back(StatementChild(statement));
+    this->_children.push_back(StatementChild(std::move(statement)));
     return *this;
 }
 
 Writer& Writer::Statement(const Writer& writer)
 {
-    std::stringstream out;
-    writer.Write(out);
-    return this->Statement(out.str());
+    this->_children.push_back(StatementChild(const_cast<Writer&>(writer), 4));
+    return *this;
 }
 
-Writer& Writer::Statement(const std::vector<std::string> &statements)
+Writer& Writer::Statement(std::vector<std::string> statements)
 {
-    for (auto statement : statements)
-        this->_children.push_back(StatementChild(statement));
+    for (auto& statement : statements)
+        this->_children.push_back(StatementChild(std::move(statement)));
     return *this;
 }
 
 Writer& Writer::EmptyLine()
 {
-    this->_children.push_back(StatementChild(""));
+    this->_children.push_back(StatementChild(std::string()));
     return *this;
 }
 
 Writer& Writer::Enter(Writer& child)
 {
-    this->_children.push_back(StatementChild(child));
+    this->_children.push_back(StatementChild(child, 1));
     return *this;
 }
 
-void Writer::Write(std::ostream& out, int depth) const
+void Writer::Write(std::string& out, int depth) const
 {
-    for (auto child : this->_children)
+    for (auto& child : this->_children)
     {
         if (child._type == 0)
-            out << writeTabs(depth) << child._statement << std::endl;
+        {
+            writeTabs(out, depth);
+            append(out, child._statement, "\n");
+        }
         else if (child._type == 1)
         {
-            out << writeTabs(depth) << "{" << std::endl;
+            writeTabs(out, depth);
+            out.append("{\n");
             child._scope.Write(out, depth + 1);
-            out << writeTabs(depth) << "}" << std::endl;
+            writeTabs(out, depth);
+            out.append("}\n");
         }
         else if (child._type == 2)
         {
-            out << writeTabs(depth) << "#ifdef " << child._statement << std::endl;
+            writeTabs(out, depth);
+            append(out, "#ifdef ", child._statement, "\n");
             child._scope.Write(out, depth);
-            out << writeTabs(depth) << "#endif // " << child._statement << std::endl;
+            writeTabs(out, depth);
+            append(out, "#endif // ", child._statement, "\n");
         }
         else if (child._type == 3)
         {
-            out << writeTabs(depth) << "#ifndef " << child._statement << std::endl;
+            writeTabs(out, depth);
+            append(out, "#ifndef ", child._statement, "\n");
             child._scope.Write(out, depth);
-            out << writeTabs(depth) << "#endif // " << child._statement << std::endl;
+            writeTabs(out, depth);
+            append(out, "#endif // ", child._statement, "\n");
+        }
+        else if (child._type == 4)
+        {
+            writeTabs(out, depth);
+            child._scope.Write(out);
+            out.append("\n");
         }
     }
 }
+
+void Writer::Write(std::ostream& out) const
+{
+    std::string buffer;
+    this->Write(buffer);
+    out.write(buffer.data(), std::streamsize(buffer.size()));
+}